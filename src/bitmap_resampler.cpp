@@ -0,0 +1,160 @@
+#include "bitmap_resampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+// The source pixels under each output pixel along one axis. `weights` holds
+// `count` consecutive values per output pixel.
+struct Filter {
+  struct Taps {
+    int start{0};
+    int count{0};
+  };
+
+  std::vector<Taps> taps;
+  std::vector<float> weights;
+};
+
+// Source pixel `i` covers [sourceStart + i, sourceStart + i + 1) and output
+// pixel `j` covers [outputStart + j, outputStart + j + 1) times 1 / scale,
+// both relative to the glyph origin.
+Filter MakeFilter(const int &sourceStart, const int &sourceLength,
+                  const int &outputStart, const int &outputLength,
+                  const float &scale) {
+  Filter filter;
+  filter.taps.reserve(outputLength);
+
+  for (int j = 0; j < outputLength; j++) {
+    const float low = (outputStart + j) / scale - sourceStart;
+    const float high = (outputStart + j + 1) / scale - sourceStart;
+
+    const int first = std::max(static_cast<int>(std::floor(low)), 0);
+    const int last =
+        std::min(static_cast<int>(std::ceil(high)), sourceLength);
+
+    filter.taps.push_back(
+        {.start = first, .count = std::max(last - first, 0)});
+    for (int i = first; i < last; i++) {
+      const float covered =
+          std::min<float>(i + 1, high) - std::max<float>(i, low);
+      filter.weights.push_back(covered * scale);
+    }
+  }
+
+  return filter;
+}
+
+// Adds `weight` times `row` to `sum`.
+void AccumulateRow(float *sum, const float *row, const float &weight,
+                   const int &width) {
+  int x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128 w = _mm_set1_ps(weight);
+  for (; x + 4 <= width; x += 4) {
+    const __m128 value = _mm_mul_ps(_mm_loadu_ps(row + x), w);
+    _mm_storeu_ps(sum + x, _mm_add_ps(_mm_loadu_ps(sum + x), value));
+  }
+#endif
+
+  for (; x < width; x++) {
+    sum[x] += row[x] * weight;
+  }
+}
+
+// Rounds and saturates the sums to coverage values.
+void StoreRow(uint8_t *output, const float *sum, const int &width) {
+  int x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+  for (; x + 8 <= width; x += 8) {
+    const __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(sum + x));
+    const __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(sum + x + 4));
+    const __m128i words = _mm_packs_epi32(low, high);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(output + x),
+                     _mm_packus_epi16(words, words));
+  }
+#endif
+
+  for (; x < width; x++) {
+    output[x] = static_cast<uint8_t>(std::clamp(std::lround(sum[x]), 0L, 255L));
+  }
+}
+} // namespace
+
+GlyphBitmap ResampleBitmap(const GlyphBitmap &source, const float &scale) {
+  GlyphBitmap output{
+      .advance = static_cast<int>(std::lround(source.advance * scale)),
+  };
+
+  if (source.width == 0 || source.height == 0)
+    return output;
+
+  // Columns grow to the right from the origin, rows grow down from the top of
+  // the glyph.
+  const int sourceLeft = source.bound.x;
+  const int sourceTop = -(source.bound.y + source.bound.h);
+
+  const int left = static_cast<int>(std::floor(sourceLeft * scale));
+  const int right = static_cast<int>(
+      std::ceil((sourceLeft + source.width) * scale));
+  const int top = static_cast<int>(std::floor(sourceTop * scale));
+  const int bottom =
+      static_cast<int>(std::ceil((sourceTop + source.height) * scale));
+
+  output.width = right - left;
+  output.height = bottom - top;
+  output.bound = {left, -bottom, output.width, output.height};
+
+  const auto columns =
+      MakeFilter(sourceLeft, source.width, left, output.width, scale);
+  const auto rows =
+      MakeFilter(sourceTop, source.height, top, output.height, scale);
+
+  // Horizontal pass, one float per output column and source row.
+  std::vector<float> narrowed(static_cast<size_t>(output.width) *
+                              source.height);
+  for (int y = 0; y < source.height; y++) {
+    const auto *line = source.pixels.data() + y * source.width;
+    auto *target = narrowed.data() + y * output.width;
+
+    const float *weight = columns.weights.data();
+    for (int x = 0; x < output.width; x++) {
+      const auto &taps = columns.taps[x];
+
+      float sum = 0;
+      for (int i = 0; i < taps.count; i++) {
+        sum += line[taps.start + i] * weight[i];
+      }
+      target[x] = sum;
+      weight += taps.count;
+    }
+  }
+
+  // Vertical pass over whole rows, which vectorizes.
+  output.pixels.resize(static_cast<size_t>(output.width) * output.height);
+  std::vector<float> sum(output.width);
+
+  const float *weight = rows.weights.data();
+  for (int y = 0; y < output.height; y++) {
+    const auto &taps = rows.taps[y];
+
+    std::ranges::fill(sum, 0.0f);
+    for (int i = 0; i < taps.count; i++) {
+      AccumulateRow(sum.data(),
+                    narrowed.data() + (taps.start + i) * output.width,
+                    weight[i], output.width);
+    }
+    weight += taps.count;
+
+    StoreRow(output.pixels.data() + y * output.width, sum.data(),
+             output.width);
+  }
+
+  return output;
+}
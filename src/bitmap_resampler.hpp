@@ -0,0 +1,15 @@
+#ifndef BITMAP_RESAMPLER_HPP
+#define BITMAP_RESAMPLER_HPP
+
+#include "font.hpp"
+
+/*
+ * Scales a glyph bitmap down by `scale`, between 0 and 1, with an area
+ * filter: each output pixel is the average of the source pixels under it,
+ * weighted by how much of them it covers. The pixel grid stays aligned to the
+ * glyph origin, so the result lines up with the glyph rasterized at the
+ * smaller size.
+ */
+GlyphBitmap ResampleBitmap(const GlyphBitmap &source, const float &scale);
+
+#endif
@@ -0,0 +1,119 @@
+#include "cluster_index.hpp"
+
+#include <algorithm>
+
+void ClusterIndex::Clear(const bool &newIsVertical) {
+  isVertical = newIsVertical;
+  lines.clear();
+  clusters.clear();
+  glyphs.clear();
+}
+
+void ClusterIndex::AddLine(const size_t &paragraph, const LayoutLine &line,
+                           const float &x, const float &y, const float &ascend,
+                           const float &descend) {
+  // The cluster starts in logical order, a cluster ends where the next one
+  // starts.
+  std::vector<size_t> starts;
+  for (const auto &run : line.runs) {
+    for (size_t i = run.glyphStart; i < run.glyphEnd; i++) {
+      starts.push_back(run.offset + run.shaped->glyphs[i].cluster);
+    }
+  }
+  std::ranges::sort(starts);
+  const auto duplicates = std::ranges::unique(starts);
+  starts.erase(duplicates.begin(), duplicates.end());
+
+  const auto clusterEnd = [&starts, &line](const size_t &start) {
+    auto next = std::ranges::upper_bound(starts, start);
+    return next != starts.end() ? *next : line.end;
+  };
+
+  const float across = Across(x, y);
+  lines.push_back({
+      .crossStart = across + std::min(ascend, descend),
+      .crossEnd = across + std::max(ascend, descend),
+      .clusterStart = clusters.size(),
+  });
+
+  float penX = x;
+  float penY = y;
+
+  for (const auto &run : line.runs) {
+    for (size_t i = run.glyphStart; i < run.glyphEnd; i++) {
+      const auto &glyph = run.shaped->glyphs[i];
+      const size_t start = run.offset + glyph.cluster;
+
+      if (i == run.glyphStart ||
+          run.shaped->glyphs[i - 1].cluster != glyph.cluster) {
+        clusters.push_back({
+            .left = isVertical ? across + std::min(ascend, descend) : penX,
+            .bottom = isVertical ? penY : penY + std::min(ascend, descend),
+            .right = isVertical ? across + std::max(ascend, descend) : penX,
+            .top = isVertical ? penY : penY + std::max(ascend, descend),
+            .paragraph = paragraph,
+            .textStart = start,
+            .textEnd = clusterEnd(start),
+            .glyphStart = glyphs.size(),
+        });
+      }
+
+      glyphs.push_back({
+          .index = glyph.index,
+          .x = penX,
+          .y = penY,
+          .xAdvance = glyph.xAdvance,
+          .yAdvance = glyph.yAdvance,
+          .xOffset = glyph.xOffset,
+          .yOffset = glyph.yOffset,
+      });
+
+      penX += HBPosToFloat(glyph.xAdvance);
+      penY += HBPosToFloat(glyph.yAdvance);
+
+      auto &cluster = clusters.back();
+      cluster.glyphEnd = glyphs.size();
+      if (isVertical) {
+        cluster.bottom = penY;
+      } else {
+        cluster.right = penX;
+      }
+    }
+  }
+
+  lines.back().clusterEnd = clusters.size();
+}
+
+const ClusterHit *ClusterIndex::Find(const float &x, const float &y) const {
+  const float across = Across(x, y);
+  const float along = Along(x, y);
+
+  // Lines are drawn away from the origin of the cross axis.
+  auto line = std::ranges::partition_point(
+      lines, [&across](const Line &l) { return l.crossStart > across; });
+  if (line == lines.end() || across > line->crossEnd)
+    return nullptr;
+
+  const auto alongStart = [this](const ClusterHit &c) {
+    return isVertical ? -c.top : c.left;
+  };
+  const auto alongEnd = [this](const ClusterHit &c) {
+    return isVertical ? -c.bottom : c.right;
+  };
+
+  const auto first = clusters.begin() + line->clusterStart;
+  const auto last = clusters.begin() + line->clusterEnd;
+
+  auto cluster = std::upper_bound(
+      first, last, along, [&alongStart](const float &a, const ClusterHit &c) {
+        return a < alongStart(c);
+      });
+  if (cluster == first)
+    return nullptr;
+
+  cluster--;
+  if (along >= alongEnd(*cluster))
+    return nullptr;
+
+  return &*cluster;
+}
@@ -0,0 +1,88 @@
+#ifndef CLUSTER_INDEX_HPP
+#define CLUSTER_INDEX_HPP
+
+#include "text_layout.hpp"
+#include <cstddef>
+#include <vector>
+
+// Positions are in viewport coordinates with the origin in the bottom-left
+// corner, like the Draw functions.
+
+struct GlyphHit {
+  hb_codepoint_t index{0};
+
+  // Pen position before the glyph.
+  float x{0};
+  float y{0};
+
+  hb_position_t xAdvance{0};
+  hb_position_t yAdvance{0};
+  hb_position_t xOffset{0};
+  hb_position_t yOffset{0};
+};
+
+struct ClusterHit {
+  // The box of the cluster: along the line from the pen position before its
+  // first glyph to the one after its last glyph, across it the line extent.
+  float left{0};
+  float bottom{0};
+  float right{0};
+  float top{0};
+
+  // UTF-16 range within the paragraph.
+  size_t paragraph{0};
+  size_t textStart{0};
+  size_t textEnd{0};
+
+  // Range in ClusterIndex::Glyphs().
+  size_t glyphStart{0};
+  size_t glyphEnd{0};
+};
+
+/*
+ * Keeps where the clusters of the drawn lines ended up, so a point can be
+ * mapped back to the text. Lines are found by a binary search on their
+ * position across the text, then the cluster by a binary search along the
+ * line, since both are stored in visual order.
+ */
+class ClusterIndex {
+public:
+  void Clear(const bool &isVertical);
+
+  // Lines must be added in the order they are drawn. `x` and `y` are the pen
+  // position at the start of the line.
+  void AddLine(const size_t &paragraph, const LayoutLine &line, const float &x,
+               const float &y, const float &ascend, const float &descend);
+
+  // Returns null when no cluster is at the point.
+  const ClusterHit *Find(const float &x, const float &y) const;
+
+  const std::vector<GlyphHit> &Glyphs() const { return glyphs; }
+  size_t ClusterCount() const { return clusters.size(); }
+
+private:
+  struct Line {
+    // Across the line direction.
+    float crossStart{0};
+    float crossEnd{0};
+
+    // Range in `clusters`.
+    size_t clusterStart{0};
+    size_t clusterEnd{0};
+  };
+
+  // The coordinate along the lines, growing in the drawing order.
+  float Along(const float &x, const float &y) const {
+    return isVertical ? -y : x;
+  }
+  float Across(const float &x, const float &y) const {
+    return isVertical ? x : y;
+  }
+
+  bool isVertical{false};
+  std::vector<Line> lines;
+  std::vector<ClusterHit> clusters;
+  std::vector<GlyphHit> glyphs;
+};
+
+#endif
@@ -10,6 +10,14 @@ constexpr SDL_Color debugBaselineColor{0xFF, 0x00, 0x00, 0xFF};
 constexpr SDL_Color debugCaretColor{0x00, 0xFF, 0xFF, 0xFF};
 constexpr SDL_Color debugAscendColor{0x40, 0x40, 0xFF, 0x80};
 constexpr SDL_Color debugDescendColor{0x40, 0xFF, 0x40, 0x80};
+constexpr SDL_Color debugClusterColor{0xFF, 0x80, 0x00, 0xFF};
+constexpr SDL_Color debugAdvanceColor{0xFF, 0x00, 0xFF, 0xFF};
+constexpr SDL_Color debugAdvanceBoxColor{0x80, 0x80, 0xFF, 0xFF};
+
+constexpr SDL_Color clusterHighlightColor{0x00, 0x80, 0xFF, 0x40};
+
+constexpr SDL_Color comparisonCellBorderColor{0x40, 0x40, 0x40, 0xFF};
+constexpr SDL_Color glyphGridBorderColor{0x60, 0x60, 0x60, 0xFF};
 
 constexpr SDL_Color defaultForegroundColor{0x00, 0x00, 0x00, 0xFF};
 constexpr SDL_Color defaultBackgroundColor{0x80, 0x80, 0x80, 0xFF};
@@ -44,4 +52,10 @@ constexpr SDL_Color Float4ToSDLColor(const std::array<float, 4> &f4) {
   return Float4ToSDLColor(f4[0], f4[1], f4[2], f4[3]);
 }
 
+constexpr uint32_t PackColor(const SDL_Color &color) {
+  return static_cast<uint32_t>(color.r) << 24 |
+         static_cast<uint32_t>(color.g) << 16 |
+         static_cast<uint32_t>(color.b) << 8 | static_cast<uint32_t>(color.a);
+}
+
 #endif
\ No newline at end of file
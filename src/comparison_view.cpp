@@ -0,0 +1,378 @@
+#include "comparison_view.hpp"
+
+#include "colors.hpp"
+#include "font_index.hpp"
+#include "glyph_atlas.hpp"
+#include "layout_job.hpp"
+#include "thread_pool.hpp"
+#include "ui_font.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <imgui.h>
+#include <magic_enum/magic_enum_all.hpp>
+#include <magic_enum/magic_enum_containers.hpp>
+#include <memory>
+
+namespace {
+constexpr int CELL_PADDING = 8;
+
+// Past this many pages, the pages not drawn from lately are evicted.
+constexpr size_t MAX_ATLAS_PAGES = 16;
+
+struct JobInput {
+  std::filesystem::path path;
+  LayoutJobInput layout;
+
+  bool operator==(const JobInput &) const = default;
+};
+
+struct CellWorker {
+  std::filesystem::path path;
+  LayoutWorker layout;
+};
+
+struct Cell {
+  uint64_t id{0};
+
+  std::filesystem::path path;
+  bool isAxisValuesSet{false};
+  magic_enum::containers::array<VariationAxis, float> axisValues{};
+
+  std::shared_ptr<CellWorker> worker{std::make_shared<CellWorker>()};
+  std::future<LayoutJobOutput> job;
+  JobInput submitted;
+  bool isSubmitted{false};
+
+  // Set when glyphs of the cell were evicted from the atlas, so the next job
+  // rasterizes every glyph.
+  bool isAtlasStale{false};
+
+  LayoutJobOutput result;
+};
+
+std::vector<Cell> cells;
+uint64_t nextCellId = 1;
+
+// Jobs of removed cells, which still own a font until they finish.
+std::vector<std::future<LayoutJobOutput>> retiredJobs;
+
+GlyphAtlas atlas;
+
+std::chrono::steady_clock::time_point batchStart;
+std::chrono::duration<double> batchElapsed{};
+bool isBatchRunning = false;
+
+LayoutJobOutput RunJob(CellWorker &worker, const JobInput &input,
+                       const bool &isAtlasStale) {
+  if (!worker.layout.font || worker.path != input.path) {
+    auto [data, hash] = FontIndex::Shared().Load(input.path);
+
+    worker.layout.font = std::make_unique<Font>();
+    worker.layout.isAxisValuesSet = false;
+    worker.layout.font->Load(data, hash);
+    worker.path = input.path;
+  }
+
+  return RunLayoutJob(worker.layout, input.layout, isAtlasStale);
+}
+
+bool IsJobRunning(const Cell &cell) { return cell.job.valid(); }
+
+void CollectResult(SDL_Renderer *renderer, Cell &cell) {
+  if (!IsJobRunning(cell) ||
+      cell.job.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+
+  cell.result = cell.job.get();
+  UploadJobBitmaps(renderer, atlas, cell.id, cell.result);
+
+  UiFontRequest(cell.result.familyName);
+  UiFontRequest(cell.result.subFamilyName);
+}
+
+void Submit(Cell &cell, const JobInput &input) {
+  if (IsJobRunning(cell))
+    return;
+
+  if (cell.isSubmitted && !cell.isAtlasStale && cell.submitted == input)
+    return;
+
+  if (!isBatchRunning) {
+    batchStart = std::chrono::steady_clock::now();
+    isBatchRunning = true;
+  }
+
+  cell.job = ThreadPool::Shared().Submit(
+      [worker = cell.worker, input, isAtlasStale = cell.isAtlasStale]() {
+        return RunJob(*worker, input, isAtlasStale);
+      });
+
+  cell.submitted = input;
+  cell.isSubmitted = true;
+  cell.isAtlasStale = false;
+}
+
+void DrawCell(SDL_Renderer *renderer, DebugSettings &debug, const Cell &cell,
+              const SDL_Color &color) {
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  SDL_FRect border{0, 0, static_cast<float>(bound.w),
+                   static_cast<float>(bound.h)};
+  SDL_SetRenderDrawColor(renderer, comparisonCellBorderColor.r,
+                         comparisonCellBorderColor.g,
+                         comparisonCellBorderColor.b,
+                         comparisonCellBorderColor.a);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  SDL_RenderRect(renderer, &border);
+
+  const auto &result = cell.result;
+  if (!result.isValid)
+    return;
+
+  DebugOverlay overlay(renderer, debug);
+
+  const bool isRightAligned =
+      cell.submitted.layout.options.direction == HB_DIRECTION_RTL;
+  float y = bound.h - CELL_PADDING - result.lineHeight;
+
+  for (const auto &paragraph : result.paragraphs) {
+    for (const auto &line : paragraph.lines) {
+      if (y + result.ascend < 0)
+        return;
+
+      float x = isRightAligned ? bound.w - CELL_PADDING -
+                                     HBPosToFloat(line.advance)
+                               : CELL_PADDING;
+
+      // Glyphs still being rasterized are filled in on a later frame.
+      DrawAtlasLine(renderer, overlay, atlas, cell.id, result.generation, line,
+                    color, x, y);
+
+      y -= result.lineHeight;
+    }
+  }
+}
+
+void AddCell(const std::filesystem::path &path) {
+  cells.push_back({.id = nextCellId++, .path = path});
+}
+} // namespace
+
+void ComparisonTick(SDL_Renderer *renderer, DebugSettings &debug,
+                    std::u16string_view text, const int &fontSize,
+                    const LayoutOptions &options, const SDL_Color &color) {
+  if (cells.empty())
+    return;
+
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  const int columns =
+      static_cast<int>(std::ceil(std::sqrt(static_cast<double>(cells.size()))));
+  const int rows = (static_cast<int>(cells.size()) + columns - 1) / columns;
+  const int cellWidth = bound.w / columns;
+  const int cellHeight = bound.h / rows;
+
+  atlas.NextFrame();
+
+  // Cells only lay out horizontally.
+  LayoutOptions cellOptions = options;
+  if (cellOptions.direction == HB_DIRECTION_TTB) {
+    cellOptions.direction = HB_DIRECTION_LTR;
+  }
+
+  for (size_t i = 0; i < cells.size(); i++) {
+    auto &cell = cells[i];
+    CollectResult(renderer, cell);
+
+    Submit(cell, {
+                     .path = cell.path,
+                     .layout =
+                         {
+                             .fontSize = fontSize,
+                             .isAxisValuesSet = cell.isAxisValuesSet,
+                             .axisValues = cell.axisValues,
+                             .text = std::u16string(text),
+                             .options = cellOptions,
+                             .extent =
+                                 FloatToHBPos(cellWidth - 2 * CELL_PADDING),
+                         },
+                 });
+
+    SDL_Rect viewport{
+        bound.x + static_cast<int>(i % columns) * cellWidth,
+        bound.y + static_cast<int>(i / columns) * cellHeight,
+        cellWidth,
+        cellHeight,
+    };
+    SDL_SetRenderViewport(renderer, &viewport);
+
+    DrawCell(renderer, debug, cell, color);
+  }
+
+  SDL_SetRenderViewport(renderer, &bound);
+
+  // After drawing, so the pages of the visible glyphs are kept.
+  std::vector<uint64_t> evicted;
+  while (atlas.PageCount() > MAX_ATLAS_PAGES && atlas.EvictPage(&evicted)) {
+  }
+  for (auto &cell : cells) {
+    if (std::ranges::find(evicted, cell.id) != evicted.end()) {
+      cell.isAtlasStale = true;
+    }
+  }
+
+  if (isBatchRunning &&
+      std::none_of(cells.begin(), cells.end(), IsJobRunning)) {
+    batchElapsed = std::chrono::steady_clock::now() - batchStart;
+    isBatchRunning = false;
+  }
+}
+
+void ComparisonDoUI(const std::vector<std::filesystem::path> &fontFilePaths) {
+  if (ImGui::Begin("Comparison")) {
+    ImGui::BeginDisabled(fontFilePaths.empty());
+    if (ImGui::Button("Add cell##comparison")) {
+      AddCell(fontFilePaths.front());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Add all fonts##comparison")) {
+      for (const auto &path : fontFilePaths) {
+        if (!FontIndex::Shared().IsDuplicate(path)) {
+          AddCell(path);
+        }
+      }
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (ImGui::Button("Clear##comparison")) {
+      ComparisonCleanUp();
+    }
+
+    std::chrono::duration<double> totalElapsed{};
+    for (const auto &cell : cells) {
+      totalElapsed += cell.result.elapsed;
+    }
+
+    ImGui::LabelText("Worker threads", "%zu",
+                     ThreadPool::Shared().ThreadCount());
+    ImGui::LabelText("Job time (total)", "%.1f ms",
+                     totalElapsed.count() * 1000.0);
+    ImGui::LabelText("Wall time (last batch)", "%.1f ms",
+                     batchElapsed.count() * 1000.0);
+    ImGui::LabelText("Atlas", "%zu glyphs, %zu pages", atlas.GlyphCount(),
+                     atlas.PageCount());
+
+    constexpr magic_enum::containers::array<VariationAxis, const char *>
+        axisLabel{
+            "Italic", "Optical size", "Slant", "Weight", "Width",
+        };
+
+    std::optional<size_t> removed;
+    std::optional<size_t> duplicated;
+
+    for (size_t i = 0; i < cells.size(); i++) {
+      auto &cell = cells[i];
+      ImGui::PushID(static_cast<int>(cell.id));
+
+      ImGui::SeparatorText(cell.result.isValid
+                               ? cell.result.familyName.c_str()
+                               : cell.path.filename().string().c_str());
+
+      if (ImGui::BeginCombo("Font file",
+                            cell.path.filename().string().c_str())) {
+        for (const auto &path : fontFilePaths) {
+          if (path != cell.path && FontIndex::Shared().IsDuplicate(path))
+            continue;
+
+          if (ImGui::Selectable(path.filename().string().c_str(),
+                                path == cell.path)) {
+            cell.path = path;
+            cell.isAxisValuesSet = false;
+          }
+        }
+        ImGui::EndCombo();
+      }
+
+      ImGui::LabelText("Sub-family name", "%s",
+                       cell.result.subFamilyName.c_str());
+
+      magic_enum::enum_for_each<VariationAxis>([&cell, &axisLabel](
+                                                   const VariationAxis &axis) {
+        const auto &info = cell.result.axisInfos[axis];
+        if (!info.has_value())
+          return;
+
+        if (!cell.isAxisValuesSet) {
+          magic_enum::enum_for_each<VariationAxis>(
+              [&cell](const VariationAxis &a) {
+                if (cell.result.axisInfos[a].has_value()) {
+                  cell.axisValues[a] = cell.result.axisInfos[a]->defaultValue;
+                }
+              });
+          cell.isAxisValuesSet = true;
+        }
+
+        ImGui::DragFloat(axisLabel[axis], &cell.axisValues[axis], 1.0f,
+                         info->min, info->max);
+      });
+
+      ImGui::LabelText("Job time", "%.1f ms",
+                       cell.result.elapsed.count() * 1000.0);
+
+      if (ImGui::Button("Duplicate")) {
+        duplicated = i;
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Remove")) {
+        removed = i;
+      }
+
+      ImGui::PopID();
+    }
+
+    if (duplicated.has_value()) {
+      const auto &source = cells[*duplicated];
+      cells.push_back({
+          .id = nextCellId++,
+          .path = source.path,
+          .isAxisValuesSet = source.isAxisValuesSet,
+          .axisValues = source.axisValues,
+      });
+    }
+
+    if (removed.has_value()) {
+      std::erase_if(retiredJobs, [](const auto &job) {
+        return job.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+      });
+
+      auto &cell = cells[*removed];
+      if (IsJobRunning(cell)) {
+        retiredJobs.push_back(std::move(cell.job));
+      }
+      atlas.RemoveFace(cell.id);
+      cells.erase(cells.begin() + *removed);
+    }
+  }
+  ImGui::End();
+}
+
+void ComparisonCleanUp() {
+  for (auto &cell : cells) {
+    if (IsJobRunning(cell)) {
+      cell.job.wait();
+    }
+  }
+  for (auto &job : retiredJobs) {
+    job.wait();
+  }
+
+  retiredJobs.clear();
+  cells.clear();
+  atlas.Clear();
+}
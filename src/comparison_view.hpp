@@ -0,0 +1,25 @@
+#ifndef COMPARISON_VIEW_HPP
+#define COMPARISON_VIEW_HPP
+
+#include "debug_settings.hpp"
+#include "text_layout.hpp"
+#include <SDL3/SDL.h>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Renders the same text in several fonts (or several variation instances of a
+ * font) side by side. Every cell is shaped and rasterized by a job on the
+ * shared thread pool, and the glyphs of all cells are packed into one atlas.
+ */
+void ComparisonTick(SDL_Renderer *renderer, DebugSettings &debug,
+                    std::u16string_view text, const int &fontSize,
+                    const LayoutOptions &options, const SDL_Color &color);
+
+void ComparisonDoUI(const std::vector<std::filesystem::path> &fontFilePaths);
+
+void ComparisonCleanUp();
+
+#endif
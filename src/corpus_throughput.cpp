@@ -0,0 +1,331 @@
+#include "corpus_throughput.hpp"
+
+#include "font.hpp"
+#include "mapped_file.hpp"
+#include "text_layout.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <unicode/utf16.h>
+#include <unordered_map>
+#include <utf8cpp/utf8.h>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+// After windows.h, which it depends on.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+// Large enough to keep the workers busy between two chunks, small enough to
+// spread a file of a few MB over all of them.
+constexpr size_t CHUNK_SIZE = 256 * 1024;
+
+// The most frequent missing codepoints logged.
+constexpr size_t MAX_MISSING_REPORTED = 20;
+
+struct Chunk {
+  size_t start{0};
+  size_t end{0};
+};
+
+struct CorpusWorker {
+  explicit CorpusWorker(const Font &font) : font(font) {}
+
+  Font font;
+  TextLayout layout;
+
+  // Reused by every chunk.
+  std::string valid;
+  std::u16string text;
+
+  size_t paragraphs{0};
+  size_t glyphs{0};
+  size_t bitmapHits{0};
+
+  // Indexed by glyph id.
+  std::vector<bool> touched;
+  std::unordered_map<UChar32, size_t> missing;
+};
+
+// Cuts after the first line end past each CHUNK_SIZE bytes.
+std::vector<Chunk> SplitChunks(std::string_view data) {
+  std::vector<Chunk> chunks;
+
+  size_t start = 0;
+  while (start < data.size()) {
+    size_t end = data.size();
+    if (data.size() - start > CHUNK_SIZE) {
+      const auto lineEnd = data.find('\n', start + CHUNK_SIZE);
+      end = lineEnd != std::string_view::npos ? lineEnd + 1 : data.size();
+    }
+
+    chunks.push_back({.start = start, .end = end});
+    start = end;
+  }
+
+  return chunks;
+}
+
+void ProcessChunk(CorpusWorker &worker, std::string_view chunk,
+                  const LayoutOptions &options, const bool &isShapingOnly) {
+  // Would end the chunk with an empty paragraph.
+  if (chunk.ends_with('\n')) {
+    chunk.remove_suffix(1);
+  }
+
+  // A corpus may not be clean, invalid sequences become U+FFFD.
+  worker.valid.clear();
+  utf8::replace_invalid(chunk.begin(), chunk.end(),
+                        std::back_inserter(worker.valid));
+
+  worker.text.clear();
+  utf8::utf8to16(worker.valid.begin(), worker.valid.end(),
+                 std::back_inserter(worker.text));
+  std::erase(worker.text, u'\r');
+
+  auto &font = worker.font;
+  std::pmr::unsynchronized_pool_resource scratch;
+  worker.layout.Update(font, worker.text, options, TextLayout::NO_WRAP,
+                       &scratch);
+
+  worker.paragraphs += worker.layout.Paragraphs().size();
+
+  for (const auto &paragraph : worker.layout.Paragraphs()) {
+    for (size_t r = 0; r < paragraph.runs.size(); r++) {
+      const auto &run = paragraph.runs[r];
+
+      for (const auto &glyph : paragraph.shapedRuns[r]->glyphs) {
+        worker.glyphs++;
+        if (glyph.index < worker.touched.size()) {
+          worker.touched[glyph.index] = true;
+        }
+
+        if (glyph.index == 0) {
+          const auto *text = paragraph.text.data();
+          const auto length = static_cast<int32_t>(paragraph.text.size());
+          auto offset = static_cast<int32_t>(run.offset + glyph.cluster);
+
+          UChar32 codepoint;
+          U16_NEXT(text, offset, length, codepoint);
+          worker.missing[codepoint]++;
+        }
+
+        if (!isShapingOnly) {
+          const auto bitmapsBefore = font.BitmapCount();
+          font.GetBitmap(glyph.index);
+          if (font.BitmapCount() == bitmapsBefore) {
+            worker.bitmapHits++;
+          }
+        }
+      }
+    }
+  }
+}
+
+// In bytes, 0 where it is not known.
+size_t PeakResidentSize() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters{};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+#ifdef __APPLE__
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  // In kilobytes.
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+double Ratio(const size_t &count, const size_t &total) {
+  return total > 0 ? 100.0 * count / total : 0.0;
+}
+} // namespace
+
+std::optional<CorpusOptions> ParseCorpusOptions(const int &argc, char **argv) {
+  std::optional<CorpusOptions> options;
+
+  for (int i = 1; i + 1 < argc; i++) {
+    if (std::string_view(argv[i]) == "--corpus") {
+      options.emplace().corpusPath = argv[++i];
+    }
+  }
+
+  if (!options.has_value())
+    return options;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--shaping-only") {
+      options->isShapingOnly = true;
+    } else if (!hasValue) {
+      break;
+    } else if (arg == "--corpus") {
+      i++;
+    } else if (arg == "--font") {
+      options->fontPath = argv[++i];
+    } else if (arg == "--size") {
+      options->fontSize = std::atoi(argv[++i]);
+    } else if (arg == "--language") {
+      options->language = argv[++i];
+    } else if (arg == "--direction") {
+      const auto direction = hb_direction_from_string(argv[++i], -1);
+      if (direction != HB_DIRECTION_INVALID) {
+        options->direction = direction;
+      } else {
+        spdlog::warn("Unknown direction {}, use ltr, rtl or ttb", argv[i]);
+      }
+    }
+  }
+
+  return options;
+}
+
+bool RunCorpusThroughput(const CorpusOptions &options) {
+  MappedFile corpus;
+  if (!corpus.Open(options.corpusPath)) {
+    spdlog::error("Unable to read {}", options.corpusPath.string());
+    return false;
+  }
+
+  if (!Font::Init()) {
+    spdlog::error("Unable to initialize FreeType");
+    return false;
+  }
+
+  bool isDone = false;
+  {
+    Font font;
+    if (font.LoadFile(options.fontPath.string())) {
+      const std::string_view data{
+          reinterpret_cast<const char *>(corpus.Data()), corpus.Size()};
+      const auto chunks = SplitChunks(data);
+
+      const LayoutOptions layoutOptions{
+          .direction = options.direction,
+          .language = options.language,
+      };
+
+      // The calling thread takes part in ForEach too.
+      auto &pool = ThreadPool::Shared();
+      const auto workerCount =
+          std::min(pool.ThreadCount() + 1, std::max<size_t>(chunks.size(), 1));
+
+      // Copies share the font data but not the FreeType face nor the caches.
+      std::vector<std::unique_ptr<CorpusWorker>> workers;
+      for (size_t w = 0; w < workerCount; w++) {
+        auto worker = std::make_unique<CorpusWorker>(font);
+        worker->font.SetFontSize(options.fontSize);
+        worker->touched.assign(font.GlyphCount(), false);
+        workers.push_back(std::move(worker));
+      }
+
+      spdlog::info("Processing {} MB in {} chunks on {} threads",
+                   data.size() / (1024 * 1024), chunks.size(), workerCount);
+
+      const auto start = std::chrono::steady_clock::now();
+
+      std::atomic<size_t> nextChunk{0};
+      pool.ForEach(workerCount, [&](size_t w) {
+        auto &worker = *workers[w];
+        for (size_t c = nextChunk++; c < chunks.size(); c = nextChunk++) {
+          const auto &chunk = chunks[c];
+          const auto text = data.substr(chunk.start, chunk.end - chunk.start);
+          ProcessChunk(worker, text, layoutOptions, options.isShapingOnly);
+        }
+      });
+
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      const double seconds = std::max(elapsed.count(), 1e-9);
+
+      size_t paragraphs = 0;
+      size_t runs = 0;
+      size_t shapeHits = 0;
+      size_t glyphs = 0;
+      size_t bitmapHits = 0;
+      std::vector<bool> touched(font.GlyphCount(), false);
+      std::unordered_map<UChar32, size_t> missing;
+
+      for (const auto &worker : workers) {
+        paragraphs += worker->paragraphs;
+        // Paragraphs a layout kept from its previous chunk are not looked up.
+        shapeHits += worker->font.ShapeHitCount();
+        runs += worker->font.ShapeHitCount() + worker->font.ShapeMissCount();
+        glyphs += worker->glyphs;
+        bitmapHits += worker->bitmapHits;
+
+        for (size_t i = 0; i < touched.size(); i++) {
+          touched[i] = touched[i] || worker->touched[i];
+        }
+        for (const auto &[codepoint, count] : worker->missing) {
+          missing[codepoint] += count;
+        }
+      }
+
+      const auto uniqueGlyphs = std::ranges::count(touched, true);
+
+      spdlog::info("{} paragraphs, {} runs, {} glyphs in {:.2f} s", paragraphs,
+                   runs, glyphs, seconds);
+      spdlog::info("{:.0f} glyphs/s, {:.2f} MB/s", glyphs / seconds,
+                   data.size() / (1024.0 * 1024.0) / seconds);
+      spdlog::info("{} unique glyphs of {} in the font", uniqueGlyphs,
+                   font.GlyphCount());
+      spdlog::info("Shape cache hits: {:.1f}% of {} runs",
+                   Ratio(shapeHits, runs), runs);
+      if (!options.isShapingOnly) {
+        spdlog::info("Bitmap cache hits: {:.1f}% of {} glyphs",
+                     Ratio(bitmapHits, glyphs), glyphs);
+      }
+
+      std::vector<std::pair<UChar32, size_t>> missingByCount(missing.begin(),
+                                                             missing.end());
+      std::ranges::sort(missingByCount, [](const auto &a, const auto &b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+      });
+
+      size_t missingGlyphs = 0;
+      for (const auto &[codepoint, count] : missingByCount) {
+        missingGlyphs += count;
+      }
+      spdlog::info("Missing glyphs: {} for {} codepoints", missingGlyphs,
+                   missingByCount.size());
+      for (size_t i = 0;
+           i < std::min(missingByCount.size(), MAX_MISSING_REPORTED); i++) {
+        spdlog::info("  U+{:04X}: {}",
+                     static_cast<uint32_t>(missingByCount[i].first),
+                     missingByCount[i].second);
+      }
+
+      spdlog::info("Peak resident memory: {} MB",
+                   PeakResidentSize() / (1024 * 1024));
+      isDone = true;
+    } else {
+      spdlog::error("Unable to load {}", options.fontPath.string());
+    }
+  }
+
+  Font::CleanUp();
+  return isDone;
+}
@@ -0,0 +1,37 @@
+#ifndef CORPUS_THROUGHPUT_HPP
+#define CORPUS_THROUGHPUT_HPP
+
+#include <harfbuzz/hb.h>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+struct CorpusOptions {
+  std::filesystem::path corpusPath;
+  std::filesystem::path fontPath;
+
+  int fontSize{16};
+  hb_direction_t direction{HB_DIRECTION_LTR};
+  std::string language;
+
+  // Shapes only, without rasterizing the glyphs.
+  bool isShapingOnly{false};
+};
+
+// Returns nothing unless `--corpus <file>` is on the command line.
+std::optional<CorpusOptions> ParseCorpusOptions(const int &argc, char **argv);
+
+/*
+ * Pushes a UTF-8 text file through itemization, shaping and rasterization
+ * without drawing anything, and logs the throughput, the unique glyphs, the
+ * hit rates of the shape and bitmap caches, the codepoints the font has no
+ * glyph for and the peak resident memory.
+ *
+ * The file is memory mapped and cut into chunks at line ends. The workers of
+ * the thread pool take the chunks in turn, each with its own copy of the font
+ * and its own layout, so the text is never held as a whole beyond the mapping.
+ * Returns false when an input is missing.
+ */
+bool RunCorpusThroughput(const CorpusOptions &options);
+
+#endif
@@ -0,0 +1,359 @@
+#include "coverage.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <unicode/uchar.h>
+#include <unicode/ucpmap.h>
+#include <unicode/utf16.h>
+#include <unicode/utf8.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COVERAGE_SSE2
+#endif
+
+namespace {
+// The most missing codepoints listed per block.
+constexpr size_t MAX_LISTED_MISSING = 64;
+
+uint64_t Combine(const uint64_t &a, const uint64_t &b, const bool &isMissing) {
+  return isMissing ? a & ~b : a & b;
+}
+
+#ifdef COVERAGE_SSE2
+// Bit counts of the bytes of `v`, by halving the width of the sums.
+__m128i CountBytes(__m128i v) {
+  const auto m1 = _mm_set1_epi8(0x55);
+  const auto m2 = _mm_set1_epi8(0x33);
+  const auto m4 = _mm_set1_epi8(0x0F);
+
+  v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi64(v, 1), m1));
+  v = _mm_add_epi8(_mm_and_si128(v, m2),
+                   _mm_and_si128(_mm_srli_epi64(v, 2), m2));
+  return _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi64(v, 4)), m4);
+}
+#endif
+
+// The bits set in `a` and in `b`, or in `a` but not in `b`, over `count`
+// words.
+size_t CountWords(const uint64_t *a, const uint64_t *b, const size_t &count,
+                  const bool &isMissing) {
+  size_t total = 0;
+  size_t i = 0;
+
+#ifdef COVERAGE_SSE2
+  // Two words per step, the byte counts are summed by the SAD against zero.
+  const auto zero = _mm_setzero_si128();
+  auto sums = zero;
+  for (; i + 2 <= count; i += 2) {
+    const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    const auto v =
+        isMissing ? _mm_andnot_si128(vb, va) : _mm_and_si128(va, vb);
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(CountBytes(v), zero));
+  }
+  total += static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+           static_cast<size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+#endif
+
+  for (; i < count; i++) {
+    total += std::popcount(Combine(a[i], b[i], isMissing));
+  }
+
+  return total;
+}
+
+// Like CountWords(), over the bits `begin` to `end` (exclusive) of a page.
+size_t CountBits(const uint64_t *a, const uint64_t *b, const size_t &begin,
+                 const size_t &end, const bool &isMissing) {
+  const size_t firstWord = begin / 64;
+  const size_t lastWord = (end - 1) / 64;
+  const uint64_t headMask = ~uint64_t{0} << (begin % 64);
+  const uint64_t tailMask = ~uint64_t{0} >> (63 - (end - 1) % 64);
+
+  const auto word = [&](const size_t &w) {
+    return Combine(a[w], b[w], isMissing);
+  };
+
+  if (firstWord == lastWord)
+    return std::popcount(word(firstWord) & headMask & tailMask);
+
+  return std::popcount(word(firstWord) & headMask) +
+         CountWords(a + firstWord + 1, b + firstWord + 1,
+                    lastWord - firstWord - 1, isMissing) +
+         std::popcount(word(lastWord) & tailMask);
+}
+
+// Calls `onRange` with the ranges of the integer property that have the
+// values `isIncluded` accepts.
+template <class F, class G>
+void ForEachPropertyRange(const UProperty &property, const F &isIncluded,
+                          const G &onRange) {
+  UErrorCode status = U_ZERO_ERROR;
+  const auto *map = u_getIntPropertyMap(property, &status);
+  if (U_FAILURE(status))
+    return;
+
+  UChar32 start = 0;
+  uint32_t value = 0;
+  UChar32 end;
+  while ((end = ucpmap_getRange(map, start, UCPMAP_RANGE_NORMAL, 0, nullptr,
+                                nullptr, &value)) >= 0) {
+    if (isIncluded(value)) {
+      onRange(static_cast<char32_t>(start), static_cast<char32_t>(end), value);
+    }
+    start = end + 1;
+  }
+}
+} // namespace
+
+CodepointSet::CodepointSet() : pages(PAGE_COUNT) {}
+
+CodepointSet CodepointSet::FromFace(hb_face_t *face) {
+  CodepointSet codepoints;
+
+  auto *set = hb_set_create();
+  hb_face_collect_unicodes(face, set);
+
+  hb_codepoint_t first = HB_SET_VALUE_INVALID;
+  hb_codepoint_t last = HB_SET_VALUE_INVALID;
+  while (hb_set_next_range(set, &first, &last)) {
+    codepoints.InsertRange(first, last);
+  }
+
+  hb_set_destroy(set);
+  return codepoints;
+}
+
+CodepointSet CodepointSet::FromText(std::u16string_view text) {
+  CodepointSet codepoints;
+
+  const auto length = static_cast<int32_t>(text.size());
+  for (int32_t i = 0; i < length;) {
+    UChar32 codepoint;
+    U16_NEXT(text.data(), i, length, codepoint);
+
+    if (!U_IS_SURROGATE(codepoint) && codepoint != '\n' && codepoint != '\r') {
+      codepoints.Insert(codepoint);
+    }
+  }
+
+  return codepoints;
+}
+
+CodepointSet CodepointSet::FromUtf8(std::string_view text) {
+  // The ICU macros take 32-bit offsets, so a large corpus is read in slices
+  // cut before a lead byte.
+  constexpr size_t SLICE_SIZE = size_t{1} << 30;
+
+  CodepointSet codepoints;
+
+  while (!text.empty()) {
+    size_t sliceSize = std::min(text.size(), SLICE_SIZE);
+    while (sliceSize < text.size() && sliceSize > 0 &&
+           (static_cast<uint8_t>(text[sliceSize]) & 0xC0) == 0x80) {
+      sliceSize--;
+    }
+
+    const auto *data = reinterpret_cast<const uint8_t *>(text.data());
+    const auto length = static_cast<int32_t>(sliceSize);
+    for (int32_t i = 0; i < length;) {
+      UChar32 codepoint;
+      U8_NEXT(data, i, length, codepoint);
+
+      if (codepoint >= 0 && codepoint != '\n' && codepoint != '\r') {
+        codepoints.Insert(codepoint);
+      }
+    }
+
+    text.remove_prefix(sliceSize);
+  }
+
+  return codepoints;
+}
+
+void CodepointSet::Insert(const char32_t &codepoint) {
+  if (codepoint > MAX_CODEPOINT)
+    return;
+
+  auto &page = pages[codepoint / PAGE_SIZE];
+  if (!page) {
+    page = std::make_unique<Page>();
+  }
+
+  const size_t bit = codepoint % PAGE_SIZE;
+  (*page)[bit / 64] |= uint64_t{1} << (bit % 64);
+}
+
+void CodepointSet::InsertRange(const char32_t &first, const char32_t &last) {
+  const auto end = std::min(last, MAX_CODEPOINT);
+  for (char32_t c = first; c <= end; c++) {
+    Insert(c);
+  }
+}
+
+bool CodepointSet::Contains(const char32_t &codepoint) const {
+  if (codepoint > MAX_CODEPOINT)
+    return false;
+
+  const auto &page = pages[codepoint / PAGE_SIZE];
+  if (!page)
+    return false;
+
+  const size_t bit = codepoint % PAGE_SIZE;
+  return ((*page)[bit / 64] >> (bit % 64)) & 1;
+}
+
+bool CodepointSet::IsEmpty() const { return Count() == 0; }
+
+size_t CodepointSet::Count(const char32_t &first, const char32_t &last) const {
+  return CountWith(nullptr, true, first, last);
+}
+
+size_t CodepointSet::CountShared(const CodepointSet &other,
+                                 const char32_t &first,
+                                 const char32_t &last) const {
+  return CountWith(&other, false, first, last);
+}
+
+size_t CodepointSet::CountMissing(const CodepointSet &other,
+                                  const char32_t &first,
+                                  const char32_t &last) const {
+  return CountWith(&other, true, first, last);
+}
+
+size_t CodepointSet::CountWith(const CodepointSet *other,
+                               const bool &isMissing, const char32_t &first,
+                               const char32_t &last) const {
+  // Stands for the pages `other` does not have.
+  static const Page empty{};
+
+  const auto end = std::min(last, MAX_CODEPOINT);
+  if (first > end)
+    return 0;
+
+  size_t count = 0;
+  for (size_t p = first / PAGE_SIZE; p <= end / PAGE_SIZE; p++) {
+    const auto &page = pages[p];
+    if (!page)
+      continue;
+
+    const Page *otherPage = other != nullptr ? other->pages[p].get() : nullptr;
+    if (otherPage == nullptr) {
+      if (!isMissing)
+        continue;
+      otherPage = &empty;
+    }
+
+    const size_t pageFirst = p * PAGE_SIZE;
+    const size_t begin = std::max<size_t>(first, pageFirst) - pageFirst;
+    const size_t pageEnd =
+        std::min<size_t>(end, pageFirst + PAGE_SIZE - 1) - pageFirst + 1;
+
+    count += CountBits(page->data(), otherPage->data(), begin, pageEnd,
+                       isMissing);
+  }
+
+  return count;
+}
+
+std::vector<char32_t> CodepointSet::Missing(const CodepointSet &other,
+                                            const char32_t &first,
+                                            const char32_t &last,
+                                            const size_t &limit) const {
+  std::vector<char32_t> missing;
+
+  const auto end = std::min(last, MAX_CODEPOINT);
+  for (char32_t c = first; c <= end && missing.size() < limit; c++) {
+    const auto &page = pages[c / PAGE_SIZE];
+    if (!page) {
+      // To the last codepoint of the page.
+      c |= PAGE_SIZE - 1;
+      continue;
+    }
+
+    if (Contains(c) && !other.Contains(c)) {
+      missing.push_back(c);
+    }
+  }
+
+  return missing;
+}
+
+size_t CodepointSet::MemorySize() const {
+  const auto allocated = std::ranges::count_if(
+      pages, [](const auto &page) { return page != nullptr; });
+
+  return allocated * sizeof(Page) + pages.size() * sizeof(pages[0]);
+}
+
+const std::vector<UnicodeBlock> &UnicodeBlocks() {
+  static const auto blocks = [] {
+    std::vector<UnicodeBlock> result;
+
+    ForEachPropertyRange(
+        UCHAR_BLOCK, [](const uint32_t &value) { return value != 0; },
+        [&result](const char32_t &first, const char32_t &last,
+                  const uint32_t &value) {
+          const auto *name = u_getPropertyValueName(
+              UCHAR_BLOCK, static_cast<int32_t>(value), U_LONG_PROPERTY_NAME);
+          result.push_back({
+              .first = first,
+              .last = last,
+              .name = name != nullptr ? name : "",
+          });
+        });
+
+    return result;
+  }();
+
+  return blocks;
+}
+
+const CodepointSet &AssignedCodepoints() {
+  static const auto assigned = [] {
+    CodepointSet result;
+
+    ForEachPropertyRange(
+        UCHAR_GENERAL_CATEGORY,
+        [](const uint32_t &value) { return value != U_UNASSIGNED; },
+        [&result](const char32_t &first, const char32_t &last,
+                  const uint32_t &) { result.InsertRange(first, last); });
+
+    return result;
+  }();
+
+  return assigned;
+}
+
+CoverageReport AnalyzeCoverage(const CodepointSet &font,
+                               const CodepointSet &text) {
+  CoverageReport report;
+
+  const auto &assigned = AssignedCodepoints();
+
+  for (const auto &block : UnicodeBlocks()) {
+    BlockCoverage coverage{
+        .block = &block,
+        .assigned = assigned.Count(block.first, block.last),
+        .covered = font.Count(block.first, block.last),
+        .used = text.Count(block.first, block.last),
+    };
+
+    if (coverage.covered == 0 && coverage.used == 0)
+      continue;
+
+    if (coverage.used > 0) {
+      coverage.missing = text.CountMissing(font, block.first, block.last);
+      coverage.missingCodepoints =
+          text.Missing(font, block.first, block.last, MAX_LISTED_MISSING);
+    }
+
+    report.covered += coverage.covered;
+    report.used += coverage.used;
+    report.missing += coverage.missing;
+    report.blocks.push_back(std::move(coverage));
+  }
+
+  return report;
+}
@@ -0,0 +1,109 @@
+#ifndef COVERAGE_HPP
+#define COVERAGE_HPP
+
+#include <harfbuzz/hb.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+ * A set of Unicode codepoints as a bitset. The codespace is cut in pages of
+ * 4096 codepoints that are only allocated once one of their codepoints is in
+ * the set, so the cmap of a font takes a few KB and can be kept for every
+ * font of a directory.
+ */
+class CodepointSet {
+public:
+  static constexpr char32_t MAX_CODEPOINT = 0x10FFFF;
+
+  CodepointSet();
+
+  // The codepoints the cmap of the font maps to a glyph.
+  static CodepointSet FromFace(hb_face_t *face);
+
+  // Invalid sequences are skipped, as are line ends.
+  static CodepointSet FromText(std::u16string_view text);
+  static CodepointSet FromUtf8(std::string_view text);
+
+  void Insert(const char32_t &codepoint);
+  void InsertRange(const char32_t &first, const char32_t &last);
+
+  bool Contains(const char32_t &codepoint) const;
+  bool IsEmpty() const;
+
+  // The ranges are inclusive.
+  size_t Count(const char32_t &first = 0,
+               const char32_t &last = MAX_CODEPOINT) const;
+
+  // Of the codepoints of this set in the range, the ones `other` contains
+  // too, and the ones it does not.
+  size_t CountShared(const CodepointSet &other, const char32_t &first = 0,
+                     const char32_t &last = MAX_CODEPOINT) const;
+  size_t CountMissing(const CodepointSet &other, const char32_t &first = 0,
+                      const char32_t &last = MAX_CODEPOINT) const;
+
+  // The first `limit` codepoints counted by CountMissing(), in order.
+  std::vector<char32_t> Missing(const CodepointSet &other,
+                                const char32_t &first, const char32_t &last,
+                                const size_t &limit) const;
+
+  // The memory taken by the allocated pages.
+  size_t MemorySize() const;
+
+private:
+  static constexpr size_t PAGE_SIZE = 4096;
+  static constexpr size_t WORDS_PER_PAGE = PAGE_SIZE / 64;
+  static constexpr size_t PAGE_COUNT = (MAX_CODEPOINT + 1) / PAGE_SIZE;
+
+  using Page = std::array<uint64_t, WORDS_PER_PAGE>;
+
+  size_t CountWith(const CodepointSet *other, const bool &isMissing,
+                   const char32_t &first, const char32_t &last) const;
+
+  std::vector<std::unique_ptr<Page>> pages;
+};
+
+struct UnicodeBlock {
+  char32_t first{0};
+  char32_t last{0};
+  std::string_view name;
+};
+
+// The blocks of the Unicode version of ICU, in codepoint order.
+const std::vector<UnicodeBlock> &UnicodeBlocks();
+
+// Every codepoint with a general category other than Cn.
+const CodepointSet &AssignedCodepoints();
+
+struct BlockCoverage {
+  const UnicodeBlock *block{nullptr};
+
+  size_t assigned{0};
+  // Mapped by the font.
+  size_t covered{0};
+
+  // Used by the text, and not mapped by the font.
+  size_t used{0};
+  size_t missing{0};
+
+  // The first of the missing codepoints.
+  std::vector<char32_t> missingCodepoints;
+};
+
+struct CoverageReport {
+  size_t covered{0};
+  size_t used{0};
+  size_t missing{0};
+
+  // The blocks the font or the text has codepoints in.
+  std::vector<BlockCoverage> blocks;
+};
+
+// `text` may be empty, to report the coverage of the font alone.
+CoverageReport AnalyzeCoverage(const CodepointSet &font,
+                               const CodepointSet &text);
+
+#endif
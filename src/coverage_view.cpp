@@ -0,0 +1,253 @@
+#include "coverage_view.hpp"
+
+#include "coverage.hpp"
+#include "font_index.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <imgui.h>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace {
+enum class CoverageSource { Text, Corpus };
+
+// The missing codepoints shown per line of the tooltip.
+constexpr size_t CODEPOINTS_PER_LINE = 8;
+
+struct FontRank {
+  std::filesystem::path path;
+  size_t missing{0};
+};
+
+CoverageSource source = CoverageSource::Text;
+bool isShowingMissingOnly = false;
+
+uint64_t textHash = 0;
+CodepointSet textCodepoints;
+
+// Set by the open dialog, which may call back from another thread.
+std::mutex corpusPathMutex;
+std::optional<std::filesystem::path> pendingCorpusPath;
+
+std::filesystem::path corpusPath;
+std::future<CodepointSet> corpusJob;
+CodepointSet corpusCodepoints;
+uint64_t corpusGeneration = 0;
+
+// What the report and the ranking were made from.
+struct ReportKey {
+  uint64_t font{0};
+  CoverageSource source{CoverageSource::Text};
+  uint64_t codepoints{0};
+  size_t indexedFiles{0};
+
+  bool operator==(const ReportKey &) const = default;
+};
+std::optional<ReportKey> reportKey;
+CoverageReport report;
+std::vector<FontRank> ranking;
+
+void StartCorpusJob() {
+  std::optional<std::filesystem::path> path;
+  {
+    std::scoped_lock lock(corpusPathMutex);
+    path.swap(pendingCorpusPath);
+  }
+  if (!path.has_value())
+    return;
+
+  // The previous job is left to finish, its result is dropped.
+  corpusPath = *path;
+  corpusJob = ThreadPool::Shared().Submit([path = *path]() {
+    MappedFile file;
+    if (!file.Open(path))
+      return CodepointSet{};
+
+    return CodepointSet::FromUtf8(
+        {reinterpret_cast<const char *>(file.Data()), file.Size()});
+  });
+}
+
+void PollCorpusJob() {
+  if (!corpusJob.valid() ||
+      corpusJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return;
+
+  corpusCodepoints = corpusJob.get();
+  corpusGeneration++;
+}
+
+void Update(Font &font, std::string_view text) {
+  const auto hash = Hash64(text.data(), text.size());
+  if (hash != textHash) {
+    textHash = hash;
+    textCodepoints = CodepointSet::FromUtf8(text);
+  }
+
+  const auto &index = FontIndex::Shared();
+  const ReportKey key{
+      .font = font.ContentHash(),
+      .source = source,
+      .codepoints = source == CoverageSource::Text ? textHash
+                                                   : corpusGeneration,
+      .indexedFiles = index.FileCount(),
+  };
+  if (key == reportKey)
+    return;
+
+  reportKey = key;
+
+  const auto &codepoints =
+      source == CoverageSource::Text ? textCodepoints : corpusCodepoints;
+
+  report = font.IsValid() ? AnalyzeCoverage(font.Coverage(), codepoints)
+                          : CoverageReport{};
+
+  ranking.clear();
+  if (codepoints.IsEmpty())
+    return;
+
+  for (const auto &entry : index.UniqueEntries()) {
+    if (!entry.coverage)
+      continue;
+
+    ranking.push_back({
+        .path = entry.path,
+        .missing = codepoints.CountMissing(*entry.coverage),
+    });
+  }
+  std::ranges::stable_sort(ranking, {}, &FontRank::missing);
+}
+
+void ShowMissingTooltip(const BlockCoverage &block) {
+  ImGui::BeginTooltip();
+
+  for (size_t i = 0; i < block.missingCodepoints.size(); i++) {
+    if (i % CODEPOINTS_PER_LINE != 0) {
+      ImGui::SameLine();
+    }
+    ImGui::Text("U+%04X",
+                static_cast<unsigned int>(block.missingCodepoints[i]));
+  }
+  if (block.missing > block.missingCodepoints.size()) {
+    ImGui::Text("and %zu more",
+                block.missing - block.missingCodepoints.size());
+  }
+
+  ImGui::EndTooltip();
+}
+
+void ShowBlocks() {
+  const auto flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                     ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_ScrollY;
+  if (!ImGui::BeginTable("blocks##coverage", 4, flags))
+    return;
+
+  ImGui::TableSetupColumn("Block");
+  ImGui::TableSetupColumn("Font");
+  ImGui::TableSetupColumn("Text");
+  ImGui::TableSetupColumn("Missing");
+  ImGui::TableHeadersRow();
+
+  for (const auto &block : report.blocks) {
+    if (isShowingMissingOnly && block.missing == 0)
+      continue;
+
+    ImGui::TableNextRow();
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%.*s", static_cast<int>(block.block->name.size()),
+                block.block->name.data());
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%zu / %zu", block.covered, block.assigned);
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%zu", block.used);
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%zu", block.missing);
+    if (block.missing > 0 && ImGui::IsItemHovered()) {
+      ShowMissingTooltip(block);
+    }
+  }
+
+  ImGui::EndTable();
+}
+} // namespace
+
+void CoverageDoUI(bool *isOpen, Font &font, std::string_view text) {
+  StartCorpusJob();
+  PollCorpusJob();
+  Update(font, text);
+
+  if (ImGui::Begin("Coverage", isOpen)) {
+    int selected = static_cast<int>(source);
+    ImGui::RadioButton("Input text##coverage", &selected,
+                       static_cast<int>(CoverageSource::Text));
+    ImGui::SameLine();
+    ImGui::RadioButton("Corpus##coverage", &selected,
+                       static_cast<int>(CoverageSource::Corpus));
+    source = static_cast<CoverageSource>(selected);
+
+    if (source == CoverageSource::Corpus) {
+      ImGui::SameLine();
+      if (ImGui::Button("Open##coverage")) {
+        SDL_ShowOpenFileDialog(
+            [](void *userdata, const char *const *filelist,
+               int filter) -> void {
+              if (filelist == nullptr || filelist[0] == nullptr) {
+                return;
+              }
+              std::scoped_lock lock(corpusPathMutex);
+              pendingCorpusPath = filelist[0];
+            },
+            nullptr, nullptr, nullptr, 0, nullptr, false);
+      }
+
+      if (corpusJob.valid()) {
+        ImGui::Text("Reading %s...", corpusPath.filename().string().c_str());
+      } else if (!corpusPath.empty()) {
+        ImGui::Text("%s", corpusPath.filename().string().c_str());
+      }
+    }
+
+    ImGui::Text("The font maps %zu codepoints in %zu blocks.", report.covered,
+                report.blocks.size());
+    ImGui::Text("%zu of the %zu codepoints of the text are missing.",
+                report.missing, report.used);
+
+    if (!ranking.empty() && ImGui::TreeNode("Fonts of the directory")) {
+      for (const auto &rank : ranking) {
+        ImGui::Text("%zu missing: %s", rank.missing,
+                    rank.path.filename().string().c_str());
+      }
+      ImGui::TreePop();
+    }
+
+    ImGui::Checkbox("Only blocks with missing codepoints",
+                    &isShowingMissingOnly);
+    ShowBlocks();
+  }
+  ImGui::End();
+}
+
+void CoverageCleanUp() {
+  if (corpusJob.valid()) {
+    corpusJob.wait();
+  }
+
+  corpusJob = {};
+  corpusCodepoints = {};
+  textCodepoints = {};
+  reportKey.reset();
+  report = {};
+  ranking.clear();
+}
@@ -0,0 +1,17 @@
+#ifndef COVERAGE_VIEW_HPP
+#define COVERAGE_VIEW_HPP
+
+#include "font.hpp"
+#include <string_view>
+
+/*
+ * Lists the Unicode blocks the font covers and the codepoints of the input
+ * text, or of a corpus file, it has no glyph for. The fonts of the directory
+ * are ranked by the codepoints of the text they miss, from the cmaps the font
+ * index reads in the background.
+ */
+void CoverageDoUI(bool *isOpen, Font &font, std::string_view text);
+
+void CoverageCleanUp();
+
+#endif
@@ -0,0 +1,126 @@
+#include "debug_overlay.hpp"
+
+#include "colors.hpp"
+#include "frame_arena.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+SDL_FColor ToFColor(const SDL_Color &color) {
+  const auto f4 = SDLColorToFloat4(color);
+  return {f4[0], f4[1], f4[2], f4[3]};
+}
+} // namespace
+
+DebugOverlay::DebugOverlay(SDL_Renderer *renderer,
+                           const DebugSettings &settings)
+    : renderer(renderer), settings(settings),
+      vertices(FrameArena::Shared().Resource()),
+      indices(FrameArena::Shared().Resource()),
+      rects(FrameArena::Shared().Resource()),
+      points(FrameArena::Shared().Resource()) {
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  width = static_cast<float>(bound.w);
+  height = static_cast<float>(bound.h);
+}
+
+DebugOverlay::~DebugOverlay() { Flush(); }
+
+void DebugOverlay::FillRect(const float &x, const float &y, const float &w,
+                            const float &h, const SDL_Color &color) {
+  if (w == 0 || h == 0)
+    return;
+
+  const float top = height - y - h;
+  AddQuad({x, top}, {x + w, top}, {x + w, top + h}, {x, top + h}, color);
+}
+
+void DebugOverlay::Rect(const float &x, const float &y, const float &w,
+                        const float &h, const SDL_Color &color) {
+  BatchOf(rects, color).push_back({x, height - y - h, w, h});
+}
+
+void DebugOverlay::Line(const float &x1, const float &y1, const float &x2,
+                        const float &y2, const SDL_Color &color) {
+  // Through the pixel centers, one pixel wide.
+  const SDL_FPoint p1{x1 + 0.5f, height - y1 + 0.5f};
+  const SDL_FPoint p2{x2 + 0.5f, height - y2 + 0.5f};
+
+  const float dx = p2.x - p1.x;
+  const float dy = p2.y - p1.y;
+  const float length = std::hypot(dx, dy);
+  if (length == 0)
+    return;
+
+  const float nx = -dy / length * 0.5f;
+  const float ny = dx / length * 0.5f;
+
+  AddQuad({p1.x + nx, p1.y + ny}, {p2.x + nx, p2.y + ny},
+          {p2.x - nx, p2.y - ny}, {p1.x - nx, p1.y - ny}, color);
+}
+
+void DebugOverlay::Point(const float &x, const float &y,
+                         const SDL_Color &color) {
+  BatchOf(points, color).push_back({x, height - y - 1});
+}
+
+void DebugOverlay::Flush() {
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+  if (!indices.empty()) {
+    SDL_RenderGeometry(renderer, nullptr, vertices.data(),
+                       static_cast<int>(vertices.size()), indices.data(),
+                       static_cast<int>(indices.size()));
+    vertices.clear();
+    indices.clear();
+  }
+
+  for (auto &batch : rects) {
+    SDL_SetRenderDrawColor(renderer, batch.color.r, batch.color.g,
+                           batch.color.b, batch.color.a);
+    SDL_RenderRects(renderer, batch.items.data(),
+                    static_cast<int>(batch.items.size()));
+  }
+  rects.clear();
+
+  for (auto &batch : points) {
+    SDL_SetRenderDrawColor(renderer, batch.color.r, batch.color.g,
+                           batch.color.b, batch.color.a);
+    SDL_RenderPoints(renderer, batch.items.data(),
+                     static_cast<int>(batch.items.size()));
+  }
+  points.clear();
+}
+
+template <class T>
+std::pmr::vector<T> &
+DebugOverlay::BatchOf(std::pmr::vector<ColorBatch<T>> &batches,
+                      const SDL_Color &color) {
+  auto iter = std::ranges::find_if(batches, [&color](const auto &batch) {
+    return PackColor(batch.color) == PackColor(color);
+  });
+  if (iter != batches.end())
+    return iter->items;
+
+  return batches
+      .emplace_back(ColorBatch<T>{
+          color, std::pmr::vector<T>(batches.get_allocator().resource())})
+      .items;
+}
+
+void DebugOverlay::AddQuad(const SDL_FPoint &p1, const SDL_FPoint &p2,
+                           const SDL_FPoint &p3, const SDL_FPoint &p4,
+                           const SDL_Color &color) {
+  const auto first = static_cast<int>(vertices.size());
+  const auto fColor = ToFColor(color);
+
+  for (const auto &p : {p1, p2, p3, p4}) {
+    vertices.push_back({.position = p, .color = fColor, .tex_coord = {0, 0}});
+  }
+
+  for (const auto &i : {0, 1, 2, 0, 2, 3}) {
+    indices.push_back(first + i);
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef DEBUG_OVERLAY_HPP
+#define DEBUG_OVERLAY_HPP
+
+#include "debug_settings.hpp"
+#include <SDL3/SDL.h>
+#include <memory_resource>
+#include <vector>
+
+/*
+ * Collects the debug geometry drawn over the text and submits it in a few
+ * calls: the filled rectangles and the lines as one triangle list, the
+ * outlines and the points in one call per color.
+ *
+ * Like the Draw functions, the coordinates have their origin in the
+ * bottom-left corner of the viewport, with the Y axis going up. The geometry
+ * lives in the frame arena, so overlays must not outlive the frame.
+ */
+class DebugOverlay {
+public:
+  DebugOverlay(SDL_Renderer *renderer, const DebugSettings &settings);
+  DebugOverlay(const DebugOverlay &) = delete;
+  DebugOverlay &operator=(const DebugOverlay &) = delete;
+
+  // Draws what was not flushed yet.
+  ~DebugOverlay();
+
+  const DebugSettings &Settings() const { return settings; }
+
+  float Width() const { return width; }
+  float Height() const { return height; }
+
+  void FillRect(const float &x, const float &y, const float &w, const float &h,
+                const SDL_Color &color);
+  void Rect(const float &x, const float &y, const float &w, const float &h,
+            const SDL_Color &color);
+  void Line(const float &x1, const float &y1, const float &x2, const float &y2,
+            const SDL_Color &color);
+  void Point(const float &x, const float &y, const SDL_Color &color);
+
+  void Flush();
+
+private:
+  template <class T> struct ColorBatch {
+    SDL_Color color;
+    std::pmr::vector<T> items;
+  };
+
+  template <class T>
+  static std::pmr::vector<T> &BatchOf(std::pmr::vector<ColorBatch<T>> &batches,
+                                      const SDL_Color &color);
+
+  void AddQuad(const SDL_FPoint &p1, const SDL_FPoint &p2,
+               const SDL_FPoint &p3, const SDL_FPoint &p4,
+               const SDL_Color &color);
+
+  SDL_Renderer *renderer;
+  const DebugSettings &settings;
+  float width{0};
+  float height{0};
+
+  std::pmr::vector<SDL_Vertex> vertices;
+  std::pmr::vector<int> indices;
+  std::pmr::vector<ColorBatch<SDL_FRect>> rects;
+  std::pmr::vector<ColorBatch<SDL_FPoint>> points;
+};
+
+#endif
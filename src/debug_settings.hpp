@@ -8,5 +8,10 @@ struct DebugSettings {
   bool debugCaret{true};
   bool debugAscend{true};
   bool debugDescend{true};
+  bool debugClusters{false};
+  bool debugAdvance{false};
+  bool debugAdvanceBox{false};
+
+  bool operator==(const DebugSettings &) const = default;
 };
 #endif
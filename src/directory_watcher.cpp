@@ -0,0 +1,79 @@
+#include "directory_watcher.hpp"
+
+#include "hash.hpp"
+#include <chrono>
+#include <string>
+
+namespace {
+constexpr auto POLL_INTERVAL = std::chrono::seconds(2);
+
+// Changes whenever a file of the directory is added, removed or modified.
+uint64_t Signature(const std::filesystem::path &path) {
+  uint64_t signature = 0;
+
+  // Runs off the UI thread, so errors must not throw.
+  std::error_code ec;
+  for (std::filesystem::directory_iterator iter(path, ec), end;
+       !ec && iter != end; iter.increment(ec)) {
+    const auto &entry = *iter;
+    const auto &name = entry.path().filename().native();
+
+    // Directories have no size, it is left at -1.
+    std::error_code entryError;
+    const auto size = entry.file_size(entryError);
+    const auto modified =
+        entry.last_write_time(entryError).time_since_epoch().count();
+
+    // Summed, so the order the files are listed in does not matter.
+    auto hash = Hash64(name.data(), name.size() * sizeof(name[0]));
+    hash = Hash64(&size, sizeof(size), hash);
+    hash = Hash64(&modified, sizeof(modified), hash);
+    signature += hash;
+  }
+
+  return signature;
+}
+} // namespace
+
+void DirectoryWatcher::Start(const std::filesystem::path &path,
+                             const Uint32 &eventType) {
+  Stop();
+
+  thread = std::jthread([this, path, eventType](std::stop_token stopToken) {
+    Run(stopToken, path, eventType);
+  });
+}
+
+void DirectoryWatcher::Stop() {
+  if (!thread.joinable())
+    return;
+
+  thread.request_stop();
+  condition.notify_all();
+  thread.join();
+}
+
+void DirectoryWatcher::Run(std::stop_token stopToken,
+                           const std::filesystem::path &path,
+                           const Uint32 &eventType) {
+  auto signature = Signature(path);
+
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      condition.wait_for(lock, stopToken, POLL_INTERVAL, [] { return false; });
+      if (stopToken.stop_requested())
+        return;
+    }
+
+    const auto newSignature = Signature(path);
+    if (newSignature == signature)
+      continue;
+
+    signature = newSignature;
+
+    SDL_Event event{};
+    event.type = eventType;
+    SDL_PushEvent(&event);
+  }
+}
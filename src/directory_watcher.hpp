@@ -0,0 +1,31 @@
+#ifndef DIRECTORY_WATCHER_HPP
+#define DIRECTORY_WATCHER_HPP
+
+#include <SDL3/SDL.h>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+// Polls a directory on its own thread and pushes an event of `eventType` when
+// a file is added, removed or modified.
+class DirectoryWatcher {
+public:
+  DirectoryWatcher() = default;
+  DirectoryWatcher(const DirectoryWatcher &) = delete;
+  DirectoryWatcher &operator=(const DirectoryWatcher &) = delete;
+  ~DirectoryWatcher() { Stop(); }
+
+  void Start(const std::filesystem::path &path, const Uint32 &eventType);
+  void Stop();
+
+private:
+  void Run(std::stop_token stopToken, const std::filesystem::path &path,
+           const Uint32 &eventType);
+
+  std::mutex mutex;
+  std::condition_variable_any condition;
+  std::jthread thread;
+};
+
+#endif
@@ -12,9 +12,8 @@
  * direction is to match the modern rendering apis such as OpenGL or DirectX.
  */
 
-void DrawGlyph(SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
-               const Glyph &g, const SDL_Color &color, const int &x,
-               const int &y) {
+void DrawGlyph(SDL_Renderer *renderer, DebugOverlay &overlay, const Glyph &g,
+               const SDL_Color &color, const int &x, const int &y) {
 
   SDL_FRect rect{
       static_cast<float>(x + g.bound.x),
@@ -23,55 +22,97 @@ void DrawGlyph(SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
       static_cast<float>(g.bound.h),
   };
 
-  SDL_Rect bound;
-  SDL_GetRenderViewport(renderer, &bound);
-
   /*
    * Adjust the coordinate, and recalculate the new y origin of the rectangle.
    *
    * The given rectangle value has its origin in the bottom-left corner while
    * SDL expects the origin in the top-left corner.
    */
-  rect.y = static_cast<float>(bound.h) - rect.y - rect.h;
+  rect.y = overlay.Height() - rect.y - rect.h;
 
-  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
   SDL_SetTextureColorMod(g.texture, color.r, color.g, color.b);
 
-  SDL_RenderTexture(renderer, g.texture, nullptr, &rect);
+  const bool isAtlasGlyph = g.source.w > 0 && g.source.h > 0;
+  SDL_RenderTexture(renderer, g.texture, isAtlasGlyph ? &g.source : nullptr,
+                    &rect);
+
+  const auto &debug = overlay.Settings();
+  if (!debug.enabled)
+    return;
 
-  if (debug.enabled && debug.debugGlyphBound) {
-    SDL_SetRenderDrawColor(renderer, debugGlyphBoundColor.r,
-                           debugGlyphBoundColor.g, debugGlyphBoundColor.b,
-                           debugGlyphBoundColor.a);
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_RenderRect(renderer, &rect);
+  if (debug.debugGlyphBound) {
+    overlay.Rect(x + g.bound.x, y + g.bound.y, g.bound.w, g.bound.h,
+                 debugGlyphBoundColor);
   }
 
-  if (debug.enabled && debug.debugCaret) {
-    SDL_FRect rect{
-        static_cast<float>(x),
-        static_cast<float>(y),
-        1,
-        1,
-    };
+  if (debug.debugCaret) {
+    overlay.Point(x, y, debugCaretColor);
+  }
+}
 
-    rect.y = static_cast<float>(bound.h) - rect.y - rect.h;
+void DrawGlyph(SDL_Renderer *renderer, DebugOverlay &overlay, const Glyph &g,
+               const SDL_Color &color, const int &x, const int &y,
+               const ShapedGlyph &glyph) {
 
-    SDL_SetRenderDrawColor(renderer, debugCaretColor.r, debugCaretColor.g,
-                           debugCaretColor.b, debugCaretColor.a);
+  auto xPos = x + HBPosToFloat(glyph.xOffset);
+  auto yPos = y + HBPosToFloat(glyph.yOffset);
 
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_RenderRect(renderer, &rect);
+  DrawGlyph(renderer, overlay, g, color, xPos, yPos);
+}
+
+void DrawGlyph(LinearCompositor &compositor, DebugOverlay &overlay,
+               const GlyphBitmap &bitmap, const SDL_Color &color, const int &x,
+               const int &y) {
+  compositor.Blend(bitmap, color, x, y);
+
+  const auto &debug = overlay.Settings();
+  if (!debug.enabled)
+    return;
+
+  if (debug.debugGlyphBound) {
+    overlay.Rect(x + bitmap.bound.x, y + bitmap.bound.y, bitmap.bound.w,
+                 bitmap.bound.h, debugGlyphBoundColor);
   }
+
+  if (debug.debugCaret) {
+    overlay.Point(x, y, debugCaretColor);
+  }
+}
+
+void DrawGlyph(LinearCompositor &compositor, DebugOverlay &overlay,
+               const GlyphBitmap &bitmap, const SDL_Color &color, const int &x,
+               const int &y, const ShapedGlyph &glyph) {
+
+  auto xPos = x + HBPosToFloat(glyph.xOffset);
+  auto yPos = y + HBPosToFloat(glyph.yOffset);
+
+  DrawGlyph(compositor, overlay, bitmap, color, xPos, yPos);
 }
 
-void DrawGlyph(SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
-               const Glyph &g, const SDL_Color &color, const int &x,
-               const int &y, const hb_glyph_position_t &hb_glyph_pos) {
+void DrawOutline(OutlineBatch &batch, DebugOverlay &overlay,
+                 const GlyphOutline &outline, const float &scale,
+                 const SDL_Color &color, const float &x, const float &y) {
+  batch.Add(outline, x, y, scale, color);
 
-  auto xPos = x + HBPosToFloat(hb_glyph_pos.x_offset);
-  auto yPos = y + HBPosToFloat(hb_glyph_pos.y_offset);
+  const auto &debug = overlay.Settings();
+  if (!debug.enabled)
+    return;
+
+  if (debug.debugGlyphBound && !outline.vertices.empty()) {
+    overlay.Rect(x + outline.xMin * scale, y + outline.yMin * scale,
+                 (outline.xMax - outline.xMin) * scale,
+                 (outline.yMax - outline.yMin) * scale, debugGlyphBoundColor);
+  }
+
+  if (debug.debugCaret) {
+    overlay.Point(x, y, debugCaretColor);
+  }
+}
 
-  DrawGlyph(renderer, debug, font, g, color, xPos, yPos);
+void DrawOutline(OutlineBatch &batch, DebugOverlay &overlay,
+                 const GlyphOutline &outline, const float &scale,
+                 const SDL_Color &color, const float &x, const float &y,
+                 const ShapedGlyph &glyph) {
+  DrawOutline(batch, overlay, outline, scale, color,
+              x + HBPosToFloat(glyph.xOffset), y + HBPosToFloat(glyph.yOffset));
 }
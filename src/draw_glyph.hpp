@@ -1,14 +1,38 @@
 #ifndef DRAW_GLYPH_HPP
 #define DRAW_GLYPH_HPP
 
+#include "debug_overlay.hpp"
 #include "font.hpp"
+#include "glyph_outline.hpp"
+#include "linear_compositor.hpp"
 
-void DrawGlyph(SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
-               const Glyph &g, const SDL_Color &color, const int &x,
+// The glyph bound and the caret go to `overlay`, drawn over the glyphs.
+void DrawGlyph(SDL_Renderer *renderer, DebugOverlay &overlay, const Glyph &g,
+               const SDL_Color &color, const int &x, const int &y);
+
+void DrawGlyph(SDL_Renderer *renderer, DebugOverlay &overlay, const Glyph &g,
+               const SDL_Color &color, const int &x, const int &y,
+               const ShapedGlyph &glyph);
+
+// Blends the coverage in linear space, `compositor` must be flushed before
+// `overlay`.
+void DrawGlyph(LinearCompositor &compositor, DebugOverlay &overlay,
+               const GlyphBitmap &bitmap, const SDL_Color &color, const int &x,
                const int &y);
 
-void DrawGlyph(SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
-               const Glyph &g, const SDL_Color &color, const int &x,
-               const int &y, const hb_glyph_position_t &hb_glyph_pos);
+void DrawGlyph(LinearCompositor &compositor, DebugOverlay &overlay,
+               const GlyphBitmap &bitmap, const SDL_Color &color, const int &x,
+               const int &y, const ShapedGlyph &glyph);
+
+// The vector counterparts, the outline goes to `batch` which must be flushed
+// before `overlay`. `scale` converts font units to pixels.
+void DrawOutline(OutlineBatch &batch, DebugOverlay &overlay,
+                 const GlyphOutline &outline, const float &scale,
+                 const SDL_Color &color, const float &x, const float &y);
+
+void DrawOutline(OutlineBatch &batch, DebugOverlay &overlay,
+                 const GlyphOutline &outline, const float &scale,
+                 const SDL_Color &color, const float &x, const float &y,
+                 const ShapedGlyph &glyph);
 
 #endif
\ No newline at end of file
@@ -1,20 +1,32 @@
 #include "font.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <harfbuzz/hb-ft.h>
 #include <magic_enum/magic_enum_all.hpp>
+#include <map>
+#include <memory_resource>
 #include <spdlog/spdlog.h>
 #include <utf8cpp/utf8.h>
 
 #include FT_SFNT_NAMES_H
 #include FT_BITMAP_H
 #include FT_MULTIPLE_MASTERS_H
+#include "bitmap_resampler.hpp"
+#include "glyph_disk_cache.hpp"
+#include "hash.hpp"
 #include "io_util.hpp"
+#include "shape_disk_cache.hpp"
 #include "text_renderer.hpp"
 #include "texture.hpp"
 
 namespace {
 
+// The sizes previewed glyphs are rasterized at. Each size is scaled down from
+// the next tier, by at most half.
+constexpr std::array<int, 4> SIZE_TIERS{64, 128, 256, 512};
+
 const std::map<VariationAxis, hb_tag_t> axisTagMap{
     {VariationAxis::Italic, HB_OT_TAG_VAR_AXIS_ITALIC},
     {VariationAxis::OpticalSize, HB_OT_TAG_VAR_AXIS_OPTICAL_SIZE},
@@ -25,6 +37,10 @@ const std::map<VariationAxis, hb_tag_t> axisTagMap{
 } // namespace
 
 FT_Library Font::library;
+std::mutex Font::libraryMutex;
+std::atomic<uint64_t> Font::nextGeneration{1};
+GlyphDiskCache *Font::diskCache{nullptr};
+ShapeDiskCache *Font::shapeDiskCache{nullptr};
 
 bool Font::Init() {
   auto error = FT_Init_FreeType(&library);
@@ -40,37 +56,66 @@ bool Font::Init() {
 
 void Font::CleanUp() { FT_Done_FreeType(library); }
 
+void Font::SetDiskCache(GlyphDiskCache *cache) { diskCache = cache; }
+
+void Font::SetShapeDiskCache(ShapeDiskCache *cache) { shapeDiskCache = cache; }
+
 Font::Font() {};
 
 Font &Font::operator=(const Font &f) {
+  if (this == &f)
+    return *this;
+
+  Release();
   data = f.data;
+  contentHash = f.contentHash;
   Initialize();
 
   return *this;
 }
 
-Font::Font(const Font &f) : data(f.data) { Initialize(); }
+Font::Font(const Font &f) : data(f.data), contentHash(f.contentHash) {
+  Initialize();
+}
+
+Font::~Font() { Release(); }
 
-Font::~Font() {
-  if (data.size() == 0){
+void Font::Release() {
+  if (ftFace == nullptr)
     return;
-  }
 
+  shapePlans.Clear();
   hb_font_destroy(hbFont);
   hbFont = nullptr;
 
   Invalidate();
+  axisInfo = {};
 
+  std::scoped_lock lock(libraryMutex);
   FT_Done_Face(ftFace);
+  ftFace = nullptr;
 }
 
 bool Font::LoadFile(const std::string &path) {
-  data = ::LoadFile<std::vector<char>>(path, std::ios::in | std::ios::binary);
+  Release();
+  data = std::make_shared<const std::vector<char>>(
+      ::LoadFile<std::vector<char>>(path, std::ios::in | std::ios::binary));
+  contentHash = 0;
   return Initialize();
 }
 
 bool Font::Load(const std::vector<char> &data) {
+  Release();
+  Font::data = std::make_shared<const std::vector<char>>(data);
+  contentHash = 0;
+  return Initialize();
+}
+
+bool Font::Load(const std::shared_ptr<const std::vector<char>> &data,
+                const uint64_t &contentHash) {
+  Release();
   Font::data = data;
+  Font::contentHash = contentHash;
   return Initialize();
 }
 
@@ -88,30 +133,55 @@ static std::string ConvertFromFontString(const char *str, const int &length) {
 }
 
 bool Font::Initialize() {
-  if(data.size() == 0 ) {
+  if (!data || data->empty()) {
+    data.reset();
     return false;
   }
 
   family = "";
   subFamily = "";
 
+  std::unique_lock lock(libraryMutex);
   auto error = FT_New_Memory_Face(
-      library, reinterpret_cast<const FT_Byte *>(data.data()), data.size(), 0,
+      library, reinterpret_cast<const FT_Byte *>(data->data()), data->size(), 0,
       &ftFace);
+  lock.unlock();
 
   if (error) {
-    data.clear();
+    data.reset();
     return false;
   }
 
   hbFont = hb_ft_font_create_referenced(ftFace);
 
   Invalidate();
+  glyphs.Reset(ftFace->num_glyphs);
+  outlines.clear();
+  tierBitmaps.clear();
+  codepoints.reset();
   fontSize = -1;
 
+  if (contentHash == 0) {
+    contentHash = Hash64(data->data(), data->size());
+  }
+  variationHash = 0;
+
   family = ftFace->family_name;
   subFamily = ftFace->style_name;
 
+  featureTags.clear();
+  auto hbFace = hb_font_get_face(hbFont);
+  for (const auto &table : {HB_OT_TAG_GSUB, HB_OT_TAG_GPOS}) {
+    auto count = hb_ot_layout_table_get_feature_tags(hbFace, table, 0, nullptr,
+                                                     nullptr);
+    std::vector<hb_tag_t> tags(count);
+    hb_ot_layout_table_get_feature_tags(hbFace, table, 0, &count, tags.data());
+    featureTags.insert(featureTags.end(), tags.begin(), tags.begin() + count);
+  }
+  std::ranges::sort(featureTags);
+  const auto duplicates = std::ranges::unique(featureTags);
+  featureTags.erase(duplicates.begin(), duplicates.end());
+
   if (IsVariableFont()) {
     auto hb_face = hb_font_get_face(hbFont);
     auto count = hb_ot_var_get_axis_count(hb_face);
@@ -142,10 +212,19 @@ bool Font::Initialize() {
 }
 
 void Font::Invalidate() {
-  for (auto &g : glyphMap) {
-    SDL_DestroyTexture(g.second.texture);
+  ClearGlyphs();
+  shapeCache.Clear();
+  shapePlans.Clear();
+}
+
+void Font::ClearGlyphs() {
+  for (auto &g : glyphs) {
+    SDL_DestroyTexture(g.texture);
   }
-  glyphMap.clear();
+  glyphs.Clear();
+  bitmaps.clear();
+  hasPreviewGlyphs = false;
+  generation = nextGeneration++;
 }
 
 void Font::SetFontSize(const int &size) {
@@ -168,8 +247,71 @@ void Font::SetFontSize(const int &size) {
   linegap = height + descend - ascend;
 }
 
+void Font::SetRenderMode(const RenderMode &mode) {
+  if (renderMode == mode)
+    return;
+
+  renderMode = mode;
+  tierBitmaps.clear();
+  ClearGlyphs();
+}
+
+void Font::SetPreviewing(const bool &newIsPreviewing) {
+  if (isPreviewing == newIsPreviewing)
+    return;
+
+  isPreviewing = newIsPreviewing;
+  if (isPreviewing)
+    return;
+
+  tierBitmaps.clear();
+  if (hasPreviewGlyphs) {
+    ClearGlyphs();
+  }
+}
+
+GlyphBitmap Font::CreateBitmap(const int &index) {
+  // Small glyphs are quick enough to rasterize at every size.
+  const auto tier = std::ranges::lower_bound(SIZE_TIERS, fontSize);
+  const bool isTiered = isPreviewing && fontSize > SIZE_TIERS.front() &&
+                        tier != SIZE_TIERS.end();
+
+  return isTiered ? PreviewGlyph(index, *tier) : RasterizeGlyph(index);
+}
+
 Glyph Font::CreateGlyph(SDL_Renderer *renderer, const int &index) {
-  FT_Load_Glyph(ftFace, index, FT_LOAD_RENDER);
+  auto bitmap = CreateBitmap(index);
+  auto texture = LoadTextureFromBitmap(renderer, bitmap);
+
+  return {texture, bitmap.bound, bitmap.advance};
+}
+
+GlyphBitmap Font::RasterizeGlyph(const int &index) {
+  const GlyphCacheKey key{
+      .font = contentHash,
+      .variation = variationHash,
+      .size = static_cast<uint32_t>(fontSize),
+      .glyph = static_cast<uint32_t>(index),
+      .renderMode = renderMode.Key(),
+  };
+
+  if (diskCache != nullptr) {
+    if (auto cached = diskCache->Find(key)) {
+      return *std::move(cached);
+    }
+  }
+
+  auto output = RenderGlyph(index);
+
+  if (diskCache != nullptr) {
+    diskCache->Insert(key, output);
+  }
+
+  return output;
+}
+
+GlyphBitmap Font::RenderGlyph(const int &index) {
+  FT_Load_Glyph(ftFace, index, FT_LOAD_RENDER | renderMode.LoadFlags());
 
   const auto advance = static_cast<int>(FTPosToFloat(ftFace->glyph->advance.x));
   const auto width = ftFace->glyph->bitmap.width;
@@ -179,21 +321,58 @@ Glyph Font::CreateGlyph(SDL_Renderer *renderer, const int &index) {
   FT_Bitmap_Init(&bitmap);
   FT_Bitmap_Convert(library, &ftFace->glyph->bitmap, &bitmap, 1);
 
-  auto texture = LoadTextureFromBitmap(renderer, bitmap);
+  GlyphBitmap output{
+      .width = static_cast<int>(width),
+      .height = static_cast<int>(height),
+      .advance = advance,
+  };
+
+  // Converted monochrome bitmaps only use the values 0 and 1, scale them to
+  // full coverage.
+  const int grays = std::max<int>(bitmap.num_grays, 2);
+
+  std::array<uint8_t, 256> levels;
+  for (int i = 0; i < grays; i++) {
+    const float coverage = static_cast<float>(i) / (grays - 1);
+    levels[i] = static_cast<uint8_t>(
+        std::lround(std::pow(coverage, 1.0f / renderMode.gamma) * 255.0f));
+  }
+
+  output.pixels.reserve(width * height);
+  for (unsigned int row = 0; row < bitmap.rows; row++) {
+    const auto *line = bitmap.buffer + row * bitmap.pitch;
+    for (unsigned int column = 0; column < bitmap.width; column++) {
+      output.pixels.push_back(levels[line[column]]);
+    }
+  }
 
   FT_Bitmap_Done(library, &bitmap);
 
   const auto x = static_cast<int>(ftFace->glyph->bitmap_left);
   const auto y = static_cast<int>(ftFace->glyph->bitmap_top - height);
 
-  SDL_Rect bound{
+  output.bound = {
       x,
       y,
       static_cast<int>(width),
       static_cast<int>(height),
   };
 
-  return {texture, bound, advance};
+  return output;
+}
+
+GlyphBitmap Font::PreviewGlyph(const int &index, const int &tier) {
+  const uint64_t key = (static_cast<uint64_t>(tier) << 32) | index;
+
+  auto iter = tierBitmaps.find(key);
+  if (iter == tierBitmaps.end()) {
+    FT_Set_Pixel_Sizes(ftFace, 0, tier);
+    iter = tierBitmaps.emplace(key, RenderGlyph(index)).first;
+    FT_Set_Pixel_Sizes(ftFace, 0, fontSize);
+  }
+
+  hasPreviewGlyphs = true;
+  return ResampleBitmap(iter->second, static_cast<float>(fontSize) / tier);
 }
 
 Glyph Font::CreateGlyphFromChar(SDL_Renderer *renderer, const char16_t &ch) {
@@ -203,15 +382,11 @@ Glyph Font::CreateGlyphFromChar(SDL_Renderer *renderer, const char16_t &ch) {
 }
 
 Glyph &Font::GetGlyph(SDL_Renderer *renderer, const int &index) {
-  auto iter = glyphMap.find(index);
-  if (iter == glyphMap.end()) {
-    Glyph g = CreateGlyph(renderer, index);
-    auto [i, success] = glyphMap.insert({index, g});
-
-    iter = i;
+  if (auto glyph = glyphs.Find(index)) {
+    return *glyph;
   }
 
-  return iter->second;
+  return glyphs.Insert(index, CreateGlyph(renderer, index));
 }
 
 Glyph &Font::GetGlyphFromChar(SDL_Renderer *renderer, const char16_t &ch) {
@@ -220,6 +395,141 @@ Glyph &Font::GetGlyphFromChar(SDL_Renderer *renderer, const char16_t &ch) {
   return Font::GetGlyph(renderer, index);
 }
 
+const GlyphBitmap &Font::GetBitmap(const int &index) {
+  const auto key = static_cast<unsigned int>(index);
+  if (auto iter = bitmaps.find(key); iter != bitmaps.end()) {
+    return iter->second;
+  }
+
+  return bitmaps.emplace(key, CreateBitmap(index)).first->second;
+}
+
+const GlyphBitmap &Font::GetBitmapFromChar(const char16_t &ch) {
+  const auto index = FT_Get_Char_Index(ftFace, ch);
+
+  return GetBitmap(index);
+}
+
+const GlyphOutline &Font::GetOutline(const int &index) {
+  const auto key = static_cast<unsigned int>(index);
+  if (auto iter = outlines.find(key); iter != outlines.end()) {
+    return iter->second;
+  }
+
+  // Unscaled and unhinted, so the outline works for every size.
+  FT_Load_Glyph(ftFace, index, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP);
+
+  // A 1/4096 em error is below a pixel up to sizes of a few thousand pixels.
+  const float tolerance = ftFace->units_per_EM / 4096.0f;
+
+  auto outline = TessellateOutline(ftFace->glyph->outline, tolerance);
+  outline.advance = static_cast<float>(ftFace->glyph->advance.x);
+
+  return outlines.emplace(key, std::move(outline)).first->second;
+}
+
+const GlyphOutline &Font::GetOutlineFromChar(const char16_t &ch) {
+  const auto index = FT_Get_Char_Index(ftFace, ch);
+
+  return GetOutline(index);
+}
+
+const CodepointSet &Font::Coverage() {
+  if (!codepoints) {
+    codepoints = std::make_unique<CodepointSet>(
+        IsValid() ? CodepointSet::FromFace(hb_font_get_face(hbFont))
+                  : CodepointSet{});
+  }
+
+  return *codepoints;
+}
+
+float Font::OutlineScale() const {
+  if (!IsValid() || ftFace->units_per_EM == 0)
+    return 0;
+
+  return static_cast<float>(fontSize) / ftFace->units_per_EM;
+}
+
+ShapedRunPtr Font::Shape(std::u16string_view paragraph, const TextRun &run,
+                         const FeatureSettings &features) {
+  if (auto cached = FindShaped(paragraph, run, features)) {
+    return cached;
+  }
+
+  return AddShaped(paragraph, run, features,
+                   ShapeUncached(paragraph, run, features));
+}
+
+ShapedRunPtr Font::FindShaped(std::u16string_view paragraph,
+                              const TextRun &run,
+                              const FeatureSettings &paragraphFeatures) {
+  const auto text = paragraph.substr(run.offset, run.length);
+  const auto features =
+      ClipFeatures(paragraphFeatures, run.offset, run.length);
+
+  if (auto cached = shapeCache.Find(text, run.script, run.direction,
+                                    run.language, features)) {
+    shapeHits++;
+    return cached;
+  }
+
+  if (shapeDiskCache != nullptr) {
+    if (auto shaped = shapeDiskCache->Find(ShapeKey(text, run, features))) {
+      shapeHits++;
+      return shapeCache.Insert(text, run.script, run.direction, run.language,
+                               features, *std::move(shaped));
+    }
+  }
+
+  shapeMisses++;
+  return nullptr;
+}
+
+ShapedRun Font::ShapeUncached(std::u16string_view paragraph, const TextRun &run,
+                              const FeatureSettings &paragraphFeatures) {
+  return ShapeText(hbFont, paragraph.substr(run.offset, run.length),
+                   run.script, run.direction, run.language,
+                   ClipFeatures(paragraphFeatures, run.offset, run.length),
+                   &shapePlans);
+}
+
+ShapedRunPtr Font::AddShaped(std::u16string_view paragraph, const TextRun &run,
+                             const FeatureSettings &paragraphFeatures,
+                             ShapedRun shaped) {
+  const auto text = paragraph.substr(run.offset, run.length);
+  const auto features =
+      ClipFeatures(paragraphFeatures, run.offset, run.length);
+
+  if (shapeDiskCache != nullptr) {
+    shapeDiskCache->Insert(ShapeKey(text, run, features), shaped);
+  }
+
+  return shapeCache.Insert(text, run.script, run.direction, run.language,
+                           features, std::move(shaped));
+}
+
+ShapeCacheKey Font::ShapeKey(std::u16string_view text, const TextRun &run,
+                             const FeatureSettings &features) const {
+  const auto *languageTag = hb_language_to_string(run.language);
+  const std::string_view language =
+      languageTag != nullptr ? languageTag : std::string_view{};
+
+  return {
+      .font = contentHash,
+      .variation = variationHash,
+      .text = Hash64(text.data(), text.size() * sizeof(char16_t)),
+      .language = Hash64(language.data(), language.size()),
+      .features = features.empty()
+                      ? 0
+                      : Hash64(features.data(),
+                               features.size() * sizeof(FeatureSetting)),
+      .size = static_cast<uint32_t>(fontSize),
+      .script = run.script,
+      .direction = run.direction,
+  };
+}
+
 bool Font::IsVariableFont() const {
   if (!IsValid())
     return false;
@@ -244,8 +554,13 @@ void Font::SetVariationValues(
   if (!IsValid())
     return;
 
+  // Called on every tick of a slider drag, the axes fit on the stack.
+  std::array<std::byte, 1024> storage;
+  std::pmr::monotonic_buffer_resource scratch(storage.data(), storage.size());
+
   auto axisInfos = GetAxisInfos();
-  std::vector<hb_variation_t> variations;
+  std::pmr::vector<hb_variation_t> variations(&scratch);
+  variations.reserve(axisTagMap.size());
 
   FT_MM_Var *amaster;
   FT_Get_MM_Var(ftFace, &amaster);
@@ -261,8 +576,11 @@ void Font::SetVariationValues(
       });
 
   hb_font_set_variations(hbFont, variations.data(), variations.size());
+  variationHash =
+      Hash64(variations.data(), variations.size() * sizeof(hb_variation_t));
 
-  std::vector<FT_Fixed> coords;
+  std::pmr::vector<FT_Fixed> coords(&scratch);
+  coords.reserve(amaster->num_axis);
   for (int i = 0; i < amaster->num_axis; i++) {
     auto it = std::ranges::find_if(
         axisTagMap,
@@ -285,5 +603,7 @@ void Font::SetVariationValues(
   FT_Done_MM_Var(library, amaster);
   hb_ft_font_changed(hbFont);
 
+  outlines.clear();
+  tierBitmaps.clear();
   Invalidate();
 }
\ No newline at end of file
@@ -6,19 +6,35 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include "coverage.hpp"
 #include "debug_settings.hpp"
+#include "glyph_outline.hpp"
+#include "glyph_table.hpp"
+#include "itemizer.hpp"
+#include "render_mode.hpp"
+#include "shaper.hpp"
+#include <atomic>
 #include <functional>
 #include <hb-ot.h>
 #include <iterator>
 #include <magic_enum/magic_enum_containers.hpp>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Font;
+class GlyphDiskCache;
+class ShapeDiskCache;
+struct ShapeCacheKey;
+
+// A rasterized glyph in CPU memory, one byte of coverage per pixel.
+struct GlyphBitmap {
+  int width{0};
+  int height{0};
+  std::vector<uint8_t> pixels;
 
-struct Glyph {
-  SDL_Texture *texture{nullptr};
   SDL_Rect bound{};
   int advance = 0;
 };
@@ -29,6 +45,9 @@ constexpr inline float FTPosToFloat(const FT_Pos &value) {
 constexpr inline float HBPosToFloat(const hb_position_t &value) {
   return static_cast<float>(value) / 64.0f;
 }
+constexpr inline hb_position_t FloatToHBPos(const float &value) {
+  return static_cast<hb_position_t>(value * 64.0f);
+}
 
 enum class VariationAxis {
   Italic,
@@ -49,6 +68,13 @@ public:
   static bool Init();
   static void CleanUp();
 
+  // Rasterized glyphs are looked up in and added to `cache`, which must
+  // outlive every font. Null disables it.
+  static void SetDiskCache(GlyphDiskCache *cache);
+
+  // Same as above, for the shaping results.
+  static void SetShapeDiskCache(ShapeDiskCache *cache);
+
   Font();
   Font(const Font &f);
 
@@ -59,20 +85,75 @@ public:
   bool LoadFile(const std::string &path);
   bool Load(const std::vector<char> &data);
 
+  // Shares the file data with other fonts instead of copying it. The content
+  // hash is computed when 0.
+  bool Load(const std::shared_ptr<const std::vector<char>> &data,
+            const uint64_t &contentHash = 0);
+
   void Invalidate();
 
   void SetFontSize(const int &size);
+  int FontSize() const { return fontSize; }
+
+  // While previewing, large sizes are drawn from glyphs rasterized at a few
+  // tier sizes and scaled down, so dragging the size does not rasterize the
+  // big glyphs again for every value. Ending the preview rasterizes the glyphs
+  // at the exact size.
+  void SetPreviewing(const bool &isPreviewing);
 
   std::string GetFamilyName() const { return family; }
   std::string GetSubFamilyName() const { return subFamily; }
 
   bool IsValid() const { return ftFace != nullptr; }
 
+  const std::shared_ptr<const std::vector<char>> &Data() const { return data; }
+
   bool IsVariableFont() const;
 
+  int GlyphCount() const { return ftFace != nullptr ? ftFace->num_glyphs : 0; }
+
+  // The codepoints the cmap maps to a glyph, read on the first call. The
+  // others come out as glyph 0.
+  const CodepointSet &Coverage();
+
+  // The reference is valid until the next glyph is created.
   Glyph &GetGlyph(SDL_Renderer *renderer, const int &index);
   Glyph &GetGlyphFromChar(SDL_Renderer *renderer, const char16_t &index);
 
+  // The coverage of the glyph in CPU memory, for the compositors blending on
+  // the CPU. The reference is valid until the next bitmap is created.
+  const GlyphBitmap &GetBitmap(const int &index);
+  const GlyphBitmap &GetBitmapFromChar(const char16_t &ch);
+  size_t BitmapCount() const { return bitmaps.size(); }
+
+  // Does not touch the renderer nor the glyph cache, so it can be called from
+  // a worker thread as long as no other thread uses this font at the same time.
+  GlyphBitmap RasterizeGlyph(const int &index);
+
+  // Drops the rasterized glyphs when the mode changes. The shaping does not
+  // depend on it.
+  void SetRenderMode(const RenderMode &mode);
+  const RenderMode &GetRenderMode() const { return renderMode; }
+
+  // Draws the outlines instead of the rasterized glyphs. Only scalable fonts
+  // have outlines, the others stay on bitmaps.
+  void SetVectorMode(const bool &isEnabled) { isVectorMode = isEnabled; }
+  bool IsVectorMode() const {
+    return isVectorMode && ftFace != nullptr && FT_IS_SCALABLE(ftFace);
+  }
+
+  // Outlines are in font units, so they are kept across size changes. The
+  // reference is valid until the next outline is created.
+  const GlyphOutline &GetOutline(const int &index);
+  const GlyphOutline &GetOutlineFromChar(const char16_t &ch);
+
+  // Converts font units to pixels at the current size.
+  float OutlineScale() const;
+  size_t OutlineCount() const { return outlines.size(); }
+
+  // Hash of the font file, identifies the font in the on-disk caches.
+  uint64_t ContentHash() const { return contentHash; }
+
   float Ascend() const { return ascend; }
   float Descend() const { return descend; }
   float LineGap() const { return linegap; }
@@ -80,6 +161,35 @@ public:
 
   hb_font_t *HbFont() const { return hbFont; }
 
+  // Changes whenever cached glyphs and shaping results are dropped. Values are
+  // never reused, even by another font, so they can be used as cache keys.
+  uint64_t Generation() const { return generation; }
+
+  // `features` are relative to the paragraph.
+  ShapedRunPtr Shape(std::u16string_view paragraph, const TextRun &run,
+                     const FeatureSettings &features = {});
+
+  // The steps of `Shape()`, for callers shaping many runs at once. Returns
+  // null when the run is in neither the memory nor the disk cache.
+  ShapedRunPtr FindShaped(std::u16string_view paragraph, const TextRun &run,
+                          const FeatureSettings &features);
+
+  // Leaves the caches alone, so several threads may shape with the same font
+  // at once, as long as nothing else uses it meanwhile.
+  ShapedRun ShapeUncached(std::u16string_view paragraph, const TextRun &run,
+                          const FeatureSettings &features);
+
+  ShapedRunPtr AddShaped(std::u16string_view paragraph, const TextRun &run,
+                         const FeatureSettings &features, ShapedRun shaped);
+
+  // Lookups of FindShaped(), Shape() included. Runs read from the disk cache
+  // count as hits.
+  size_t ShapeHitCount() const { return shapeHits; }
+  size_t ShapeMissCount() const { return shapeMisses; }
+
+  // The GSUB and GPOS feature tags of the font, sorted and without duplicates.
+  const std::vector<hb_tag_t> &FeatureTags() const { return featureTags; }
+
   magic_enum::containers::array<VariationAxis, std::optional<AxisInfo>>
   GetAxisInfos() const;
 
@@ -89,18 +199,59 @@ public:
 private:
   static FT_Library library;
 
+  // Guards creating and destroying faces, which modify the library.
+  static std::mutex libraryMutex;
+
+  static std::atomic<uint64_t> nextGeneration;
+
+  static GlyphDiskCache *diskCache;
+  static ShapeDiskCache *shapeDiskCache;
+
   bool Initialize();
 
+  // Destroys the FreeType face and the HarfBuzz font, which read from `data`,
+  // so it must run before `data` is replaced.
+  void Release();
+
+  ShapeCacheKey ShapeKey(std::u16string_view text, const TextRun &run,
+                         const FeatureSettings &features) const;
+
+  // Drops the rasterized glyphs but keeps the shaping results.
+  void ClearGlyphs();
+
+  // Rasterizes at the exact size, or from a size tier while previewing.
+  GlyphBitmap CreateBitmap(const int &index);
   Glyph CreateGlyph(SDL_Renderer *renderer, const int &ch);
   Glyph CreateGlyphFromChar(SDL_Renderer *renderer, const char16_t &ch);
+  GlyphBitmap RenderGlyph(const int &index);
+  GlyphBitmap PreviewGlyph(const int &index, const int &tier);
 
-  std::vector<char> data{};
+  // Shared between copies, FreeType reads the faces straight from it.
+  std::shared_ptr<const std::vector<char>> data{};
   FT_Face ftFace{};
   hb_font_t *hbFont{nullptr};
 
   int fontSize{-1};
-
-  std::map<unsigned int, Glyph> glyphMap;
+  uint64_t generation{0};
+
+  uint64_t contentHash{0};
+  uint64_t variationHash{0};
+
+  GlyphTable glyphs;
+  std::unordered_map<unsigned int, GlyphBitmap> bitmaps;
+  std::unordered_map<unsigned int, GlyphOutline> outlines;
+  std::unique_ptr<CodepointSet> codepoints;
+
+  // Keyed by the tier size in the upper half and the glyph index.
+  std::unordered_map<uint64_t, GlyphBitmap> tierBitmaps;
+  RenderMode renderMode{};
+  bool isPreviewing{false};
+  bool hasPreviewGlyphs{false};
+  bool isVectorMode{false};
+  ShapeCache shapeCache;
+  size_t shapeHits{0};
+  size_t shapeMisses{0};
+  ShapePlanCache shapePlans;
 
   float ascend{0};
   float descend{0};
@@ -110,6 +261,8 @@ private:
   std::string family;
   std::string subFamily;
 
+  std::vector<hb_tag_t> featureTags;
+
   magic_enum::containers::array<VariationAxis, std::optional<AxisInfo>>
       axisInfo{};
 };
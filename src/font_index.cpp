@@ -0,0 +1,164 @@
+#include "font_index.hpp"
+
+#include "hash.hpp"
+#include "io_util.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <harfbuzz/hb.h>
+#include <spdlog/spdlog.h>
+
+namespace {
+FontIndexEntry HashFile(const std::filesystem::path &path) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    spdlog::warn("Unable to index {}.", path.string());
+    return {.path = path};
+  }
+
+  // The mapping outlives the blob, which is not written to.
+  auto *blob = hb_blob_create(
+      reinterpret_cast<const char *>(file.Data()),
+      static_cast<unsigned int>(file.Size()), HB_MEMORY_MODE_READONLY,
+      nullptr, nullptr);
+  auto *face = hb_face_create(blob, 0);
+  auto coverage =
+      std::make_shared<const CodepointSet>(CodepointSet::FromFace(face));
+  hb_face_destroy(face);
+  hb_blob_destroy(blob);
+
+  return {
+      .path = path,
+      .size = file.Size(),
+      .hash = Hash64(file.Data(), file.Size()),
+      .coverage = std::move(coverage),
+  };
+}
+} // namespace
+
+FontIndex &FontIndex::Shared() {
+  static FontIndex index;
+
+  return index;
+}
+
+void FontIndex::Scan(const std::vector<std::filesystem::path> &paths) {
+  std::scoped_lock lock(mutex);
+
+  // Jobs of the previous scan still finish, their results are dropped.
+  jobs.clear();
+  entries.clear();
+  canonical.clear();
+
+  for (const auto &path : paths) {
+    jobs.push_back(
+        ThreadPool::Shared().Submit([path]() { return HashFile(path); }));
+  }
+}
+
+void FontIndex::Poll() {
+  std::scoped_lock lock(mutex);
+
+  std::erase_if(jobs, [this](auto &job) {
+    if (job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return false;
+
+    auto entry = job.get();
+    if (entry.size == 0)
+      return true;
+
+    auto [iter, isInserted] = canonical.try_emplace(entry.hash, entry.path);
+    if (!isInserted && entry.path < iter->second) {
+      iter->second = entry.path;
+    }
+
+    entries.insert_or_assign(entry.path, std::move(entry));
+
+    return true;
+  });
+}
+
+size_t FontIndex::PendingCount() const {
+  std::scoped_lock lock(mutex);
+  return jobs.size();
+}
+
+size_t FontIndex::FileCount() const {
+  std::scoped_lock lock(mutex);
+  return entries.size();
+}
+
+size_t FontIndex::UniqueCount() const {
+  std::scoped_lock lock(mutex);
+  return canonical.size();
+}
+
+std::optional<uint64_t>
+FontIndex::Hash(const std::filesystem::path &path) const {
+  std::scoped_lock lock(mutex);
+
+  auto iter = entries.find(path);
+  if (iter == entries.end())
+    return std::nullopt;
+
+  return iter->second.hash;
+}
+
+std::vector<FontIndexEntry> FontIndex::UniqueEntries() const {
+  std::scoped_lock lock(mutex);
+
+  std::vector<FontIndexEntry> unique;
+  unique.reserve(canonical.size());
+  for (const auto &[hash, path] : canonical) {
+    unique.push_back(entries.at(path));
+  }
+
+  std::ranges::sort(unique, {}, &FontIndexEntry::path);
+  return unique;
+}
+
+std::filesystem::path
+FontIndex::Canonical(const std::filesystem::path &path) const {
+  std::scoped_lock lock(mutex);
+
+  auto entry = entries.find(path);
+  if (entry == entries.end())
+    return path;
+
+  return canonical.at(entry->second.hash);
+}
+
+FontIndex::Data FontIndex::Load(const std::filesystem::path &path) {
+  {
+    std::scoped_lock lock(mutex);
+
+    auto entry = entries.find(path);
+    if (entry != entries.end()) {
+      auto iter = loaded.find(entry->second.hash);
+      if (iter != loaded.end()) {
+        if (auto data = iter->second.lock()) {
+          return {data, entry->second.hash};
+        }
+      }
+    }
+  }
+
+  // The file may have changed since it was indexed, so it is hashed again.
+  auto data = std::make_shared<const std::vector<char>>(
+      LoadFile<std::vector<char>>(path, std::ios::in | std::ios::binary));
+  const auto hash = Hash64(data->data(), data->size());
+
+  std::scoped_lock lock(mutex);
+
+  std::erase_if(loaded, [](const auto &e) { return e.second.expired(); });
+
+  auto &slot = loaded[hash];
+  if (auto existing = slot.lock()) {
+    return {existing, hash};
+  }
+
+  slot = data;
+
+  return {data, hash};
+}
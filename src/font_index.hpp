@@ -0,0 +1,75 @@
+#ifndef FONT_INDEX_HPP
+#define FONT_INDEX_HPP
+
+#include "coverage.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+struct FontIndexEntry {
+  std::filesystem::path path;
+  uint64_t size{0};
+  uint64_t hash{0};
+
+  // Of the first face of the file.
+  std::shared_ptr<const CodepointSet> coverage;
+};
+
+/*
+ * Hashes the content of the font files in the background, so byte-identical
+ * copies can be told apart from actual different fonts. The hash is also the
+ * key of the per-font caches. The cmap of each file is read at the same time,
+ * while the file is mapped anyway.
+ */
+class FontIndex {
+public:
+  struct Data {
+    std::shared_ptr<const std::vector<char>> data;
+    uint64_t hash{0};
+  };
+
+  static FontIndex &Shared();
+
+  // Starts hashing `paths` on the thread pool, replacing the previous index.
+  void Scan(const std::vector<std::filesystem::path> &paths);
+
+  // Takes in the files hashed since the last call. UI thread only.
+  void Poll();
+
+  size_t PendingCount() const;
+  size_t FileCount() const;
+  size_t UniqueCount() const;
+
+  std::optional<uint64_t> Hash(const std::filesystem::path &path) const;
+
+  // One entry per distinct content, under its canonical path.
+  std::vector<FontIndexEntry> UniqueEntries() const;
+
+  // The file all the copies of `path` are shown as: the first path in order
+  // with the same content, or `path` itself when it is not indexed yet.
+  std::filesystem::path Canonical(const std::filesystem::path &path) const;
+  bool IsDuplicate(const std::filesystem::path &path) const {
+    return Canonical(path) != path;
+  }
+
+  // Reads the file, unless a file with the same content is already loaded,
+  // in which case its data is shared. Can be called from any thread.
+  Data Load(const std::filesystem::path &path);
+
+private:
+  mutable std::mutex mutex;
+
+  std::vector<std::future<FontIndexEntry>> jobs;
+  std::map<std::filesystem::path, FontIndexEntry> entries;
+  std::unordered_map<uint64_t, std::filesystem::path> canonical;
+
+  std::unordered_map<uint64_t, std::weak_ptr<const std::vector<char>>> loaded;
+};
+
+#endif
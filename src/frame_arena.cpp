@@ -0,0 +1,54 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+constexpr size_t INITIAL_CAPACITY = 64 * 1024;
+} // namespace
+
+FrameArena &FrameArena::Shared() {
+  static FrameArena arena;
+
+  return arena;
+}
+
+FrameArena::FrameArena() : block(INITIAL_CAPACITY) {
+  arena.emplace(block.data(), block.size(), &heap);
+  frame.SetUpstream(&*arena);
+}
+
+void FrameArena::Reset() {
+  lastAllocations = frame.count;
+  lastBytes = frame.bytes;
+  lastHeapAllocations = heap.count;
+
+  // Gives the blocks past `block` back to the heap.
+  arena.reset();
+
+  // Alignment padding is not counted, so leave some room for it.
+  if (heap.count > 0) {
+    block.resize(std::bit_ceil(std::max(block.size() * 2, lastBytes * 2)));
+  }
+
+  arena.emplace(block.data(), block.size(), &heap);
+  frame.SetUpstream(&*arena);
+
+  frame.count = 0;
+  frame.bytes = 0;
+  heap.count = 0;
+  heap.bytes = 0;
+}
+
+void *FrameArena::CountingResource::do_allocate(size_t size,
+                                                size_t alignment) {
+  count++;
+  bytes += size;
+
+  return upstream->allocate(size, alignment);
+}
+
+void FrameArena::CountingResource::do_deallocate(void *p, size_t size,
+                                                 size_t alignment) {
+  upstream->deallocate(p, size, alignment);
+}
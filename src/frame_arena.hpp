@@ -0,0 +1,72 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+/*
+ * Scratch memory for the UI thread, freed all at once at the end of each
+ * frame. The arena starts from one block which grows to the largest frame
+ * seen so far, so once the frames look alike it stops touching the heap.
+ *
+ * Anything allocated from it must be gone before `Reset()`.
+ */
+class FrameArena {
+public:
+  static FrameArena &Shared();
+
+  FrameArena();
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  std::pmr::memory_resource *Resource() { return &frame; }
+
+  // Called at the end of the frame.
+  void Reset();
+
+  // Of the last finished frame. Heap allocations are the blocks the arena
+  // needed on top of its own, zero once it has grown large enough.
+  size_t AllocationCount() const { return lastAllocations; }
+  size_t BytesUsed() const { return lastBytes; }
+  size_t HeapAllocationCount() const { return lastHeapAllocations; }
+
+  size_t Capacity() const { return block.size(); }
+
+private:
+  // Passes allocations through to another resource and counts them.
+  class CountingResource : public std::pmr::memory_resource {
+  public:
+    void SetUpstream(std::pmr::memory_resource *resource) {
+      upstream = resource;
+    }
+
+    size_t count{0};
+    size_t bytes{0};
+
+  private:
+    void *do_allocate(size_t size, size_t alignment) override;
+    void do_deallocate(void *p, size_t size, size_t alignment) override;
+    bool do_is_equal(const memory_resource &other) const noexcept override {
+      return this == &other;
+    }
+
+    std::pmr::memory_resource *upstream{std::pmr::new_delete_resource()};
+  };
+
+  // What the frame asks for, served by the arena.
+  CountingResource frame;
+
+  // Blocks the arena needs past `block`.
+  CountingResource heap;
+
+  std::vector<std::byte> block;
+  std::optional<std::pmr::monotonic_buffer_resource> arena;
+
+  size_t lastAllocations{0};
+  size_t lastBytes{0};
+  size_t lastHeapAllocations{0};
+};
+
+#endif
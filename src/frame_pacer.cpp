@@ -0,0 +1,80 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace {
+// ImGui needs a couple of frames to show the result of an input, e.g. a
+// hovered item or a window moved to the front.
+constexpr int SETTLE_FRAME_COUNT = 3;
+
+constexpr int MIN_FPS = 1;
+} // namespace
+
+FramePacer &FramePacer::Shared() {
+  static FramePacer pacer;
+
+  return pacer;
+}
+
+bool FramePacer::Init() {
+  wakeEventType = SDL_RegisterEvents(1);
+  if (wakeEventType == 0) {
+    spdlog::error("Unable to register the wake-up event: {}", SDL_GetError());
+    return false;
+  }
+
+  SetBenchmarkMode(isBenchmarkMode);
+
+  return true;
+}
+
+void FramePacer::Wake() {
+  if (wakeEventType == 0 || isWakePending.exchange(true))
+    return;
+
+  SDL_Event event{};
+  event.type = wakeEventType;
+  SDL_PushEvent(&event);
+}
+
+void FramePacer::OnEvent(const SDL_Event &event) {
+  if (event.type == wakeEventType) {
+    isWakePending = false;
+    return;
+  }
+
+  settleFrames = SETTLE_FRAME_COUNT;
+}
+
+void FramePacer::BeginFrame() {
+  const auto now = SDL_GetTicksNS();
+
+  if (!isBenchmarkMode) {
+    const auto frameTime = SDL_NS_PER_SECOND / static_cast<Uint64>(maxFps);
+    const auto elapsed = now - lastFrameStart;
+    if (elapsed < frameTime) {
+      SDL_DelayNS(frameTime - elapsed);
+    }
+  }
+
+  lastFrameStart = SDL_GetTicksNS();
+  frameCount++;
+}
+
+void FramePacer::EndFrame() {
+  if (settleFrames == 0)
+    return;
+
+  settleFrames--;
+  Wake();
+}
+
+void FramePacer::SetMaxFps(const int &fps) { maxFps = std::max(MIN_FPS, fps); }
+
+void FramePacer::SetBenchmarkMode(const bool &enabled) {
+  isBenchmarkMode = enabled;
+
+  // "0" lets SDL call the iterate callback as often as it can.
+  SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, isBenchmarkMode ? "0" : "waitevent");
+}
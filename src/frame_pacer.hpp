@@ -0,0 +1,50 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <SDL3/SDL.h>
+#include <atomic>
+
+/*
+ * Decides when the main loop renders. SDL waits for events between frames,
+ * and a frame is rendered after every input, after a background job is done
+ * and for a few more frames to let ImGui settle. In benchmark mode SDL
+ * iterates as fast as it can instead.
+ */
+class FramePacer {
+public:
+  static FramePacer &Shared();
+
+  bool Init();
+
+  // Makes the main loop render another frame. Can be called from any thread.
+  void Wake();
+
+  void OnEvent(const SDL_Event &event);
+
+  // Sleeps for what is left of the frame time at the max FPS.
+  void BeginFrame();
+
+  // Wakes the main loop up again while ImGui is settling.
+  void EndFrame();
+
+  int MaxFps() const { return maxFps; }
+  void SetMaxFps(const int &fps);
+
+  bool IsBenchmarkMode() const { return isBenchmarkMode; }
+  void SetBenchmarkMode(const bool &enabled);
+
+  size_t FrameCount() const { return frameCount; }
+
+private:
+  Uint32 wakeEventType{0};
+  std::atomic<bool> isWakePending{false};
+
+  int maxFps{60};
+  bool isBenchmarkMode{false};
+
+  int settleFrames{0};
+  Uint64 lastFrameStart{0};
+  size_t frameCount{0};
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "glyph_atlas.hpp"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <unordered_set>
+
+namespace {
+// Empty pixels kept around each glyph so linear filtering does not bleed the
+// neighbouring glyphs in.
+constexpr int PADDING = 1;
+
+void HashCombine(size_t &seed, const size_t &value) {
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+} // namespace
+
+GlyphAtlas::~GlyphAtlas() { Clear(); }
+
+const Glyph *GlyphAtlas::Find(const AtlasKey &key) {
+  auto iter = glyphs.find(key);
+  if (iter == glyphs.end()) {
+    return nullptr;
+  }
+
+  auto &entry = iter->second;
+  if (entry.page != 0) {
+    auto page = std::ranges::find(pages, entry.page, &Page::id);
+    if (page != pages.end()) {
+      page->lastUsed = frame;
+    }
+  }
+
+  return &entry.glyph;
+}
+
+const Glyph &GlyphAtlas::Insert(SDL_Renderer *renderer, const AtlasKey &key,
+                                const GlyphBitmap &bitmap) {
+  Glyph glyph{
+      .texture = nullptr,
+      .bound = bitmap.bound,
+      .advance = bitmap.advance,
+  };
+  uint64_t pageId = 0;
+
+  if (bitmap.width > 0 && bitmap.height > 0 &&
+      bitmap.width + PADDING <= PAGE_SIZE &&
+      bitmap.height + PADDING <= PAGE_SIZE) {
+    int x = 0;
+    int y = 0;
+
+    if (pages.empty() ||
+        !Allocate(pages.back(), bitmap.width, bitmap.height, x, y)) {
+      pages.push_back(CreatePage(renderer));
+      Allocate(pages.back(), bitmap.width, bitmap.height, x, y);
+    }
+
+    std::vector<uint32_t> pixels;
+    pixels.reserve(bitmap.pixels.size());
+    for (const auto &coverage : bitmap.pixels) {
+      pixels.push_back((static_cast<uint32_t>(coverage) << 24) | 0x00FFFFFF);
+    }
+
+    SDL_Rect rect{x, y, bitmap.width, bitmap.height};
+    SDL_UpdateTexture(pages.back().texture, &rect, pixels.data(),
+                      bitmap.width * sizeof(uint32_t));
+
+    glyph.texture = pages.back().texture;
+    pageId = pages.back().id;
+    glyph.source = {
+        static_cast<float>(x),
+        static_cast<float>(y),
+        static_cast<float>(bitmap.width),
+        static_cast<float>(bitmap.height),
+    };
+  } else if (bitmap.width > 0 && bitmap.height > 0) {
+    spdlog::warn("Glyph {} ({}x{}) is too large for the atlas.", key.glyph,
+                 bitmap.width, bitmap.height);
+  }
+
+  auto [iter, _] = glyphs.insert_or_assign(key, Entry{glyph, pageId});
+
+  return iter->second.glyph;
+}
+
+void GlyphAtlas::Clear() {
+  for (auto &page : pages) {
+    SDL_DestroyTexture(page.texture);
+  }
+
+  pages.clear();
+  glyphs.clear();
+}
+
+void GlyphAtlas::RemoveFace(const uint64_t &face) {
+  std::erase_if(glyphs, [&face](const auto &entry) {
+    return entry.first.face == face;
+  });
+
+  std::unordered_set<uint64_t> usedPages;
+  for (const auto &[key, entry] : glyphs) {
+    usedPages.insert(entry.page);
+  }
+
+  for (const auto &page : pages) {
+    if (!usedPages.contains(page.id)) {
+      SDL_DestroyTexture(page.texture);
+    }
+  }
+  std::erase_if(pages, [&usedPages](const Page &page) {
+    return !usedPages.contains(page.id);
+  });
+}
+
+bool GlyphAtlas::EvictPage(std::vector<uint64_t> *faces) {
+  auto page = std::ranges::min_element(pages, {}, &Page::lastUsed);
+  if (page == pages.end() || page->lastUsed == frame) {
+    return false;
+  }
+
+  std::erase_if(glyphs, [id = page->id, faces](const auto &entry) {
+    if (entry.second.page != id)
+      return false;
+
+    if (faces != nullptr) {
+      faces->push_back(entry.first.face);
+    }
+    return true;
+  });
+
+  SDL_DestroyTexture(page->texture);
+  pages.erase(page);
+
+  return true;
+}
+
+/*
+ * Put the glyph on the first shelf that is tall enough without wasting more
+ * than a quarter of its height, otherwise open a new shelf below the last one.
+ */
+bool GlyphAtlas::Allocate(Page &page, const int &width, const int &height,
+                          int &x, int &y) {
+  const int paddedWidth = width + PADDING;
+  const int paddedHeight = height + PADDING;
+
+  for (auto &shelf : page.shelves) {
+    if (shelf.height < paddedHeight || shelf.height * 3 > paddedHeight * 4 ||
+        shelf.x + paddedWidth > PAGE_SIZE) {
+      continue;
+    }
+
+    x = shelf.x;
+    y = shelf.y;
+    shelf.x += paddedWidth;
+
+    return true;
+  }
+
+  const int shelfY = page.shelves.empty()
+                         ? 0
+                         : page.shelves.back().y + page.shelves.back().height;
+
+  if (shelfY + paddedHeight > PAGE_SIZE) {
+    return false;
+  }
+
+  page.shelves.push_back({shelfY, paddedHeight, paddedWidth});
+  x = 0;
+  y = shelfY;
+
+  return true;
+}
+
+GlyphAtlas::Page GlyphAtlas::CreatePage(SDL_Renderer *renderer) {
+  auto texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                   SDL_TEXTUREACCESS_STATIC, PAGE_SIZE,
+                                   PAGE_SIZE);
+
+  std::vector<uint32_t> blank(PAGE_SIZE * PAGE_SIZE, 0x00FFFFFF);
+  SDL_UpdateTexture(texture, nullptr, blank.data(),
+                    PAGE_SIZE * sizeof(uint32_t));
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+  return {nextPageId++, texture, {}, frame};
+}
+
+size_t GlyphAtlas::KeyHash::operator()(const AtlasKey &key) const {
+  size_t seed = std::hash<uint64_t>{}(key.face);
+  HashCombine(seed, std::hash<uint64_t>{}(key.instance));
+  HashCombine(seed, std::hash<uint32_t>{}(key.glyph));
+
+  return seed;
+}
@@ -0,0 +1,97 @@
+#ifndef GLYPH_ATLAS_HPP
+#define GLYPH_ATLAS_HPP
+
+#include "font.hpp"
+#include <SDL3/SDL.h>
+#include <unordered_map>
+#include <vector>
+
+struct AtlasKey {
+  // Identifies the font the glyph comes from.
+  uint64_t face{0};
+
+  // Identifies the size/variation the glyph was rasterized with.
+  uint64_t instance{0};
+
+  uint32_t glyph{0};
+
+  bool operator==(const AtlasKey &) const = default;
+};
+
+/*
+ * Packs glyph bitmaps from any number of fonts into a few large textures, so
+ * glyphs rasterized by worker threads can be uploaded in one place and drawn
+ * without a texture per glyph. Pages are filled shelf by shelf, and a whole
+ * page can be evicted when it has not been drawn from recently.
+ */
+class GlyphAtlas {
+public:
+  static constexpr int PAGE_SIZE = 1024;
+
+  GlyphAtlas() = default;
+  GlyphAtlas(const GlyphAtlas &) = delete;
+  GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+  ~GlyphAtlas();
+
+  // Also marks the page of the glyph as used in the current frame.
+  const Glyph *Find(const AtlasKey &key);
+  bool Contains(const AtlasKey &key) const { return glyphs.contains(key); }
+  const Glyph &Insert(SDL_Renderer *renderer, const AtlasKey &key,
+                      const GlyphBitmap &bitmap);
+
+  void Clear();
+
+  // Drops the glyphs of the face, and the pages left without any glyph. The
+  // space the glyphs took on the other pages comes back with the page.
+  void RemoveFace(const uint64_t &face);
+
+  void NextFrame() { frame++; }
+
+  // Drops the least recently used page that was not used in this frame, with
+  // all its glyphs, and adds the faces they came from to `faces` if given.
+  // Returns false when there is no such page.
+  bool EvictPage(std::vector<uint64_t> *faces = nullptr);
+
+  size_t PageCount() const { return pages.size(); }
+  size_t GlyphCount() const { return glyphs.size(); }
+  size_t MemorySize() const {
+    return pages.size() * PAGE_SIZE * PAGE_SIZE * sizeof(uint32_t);
+  }
+
+private:
+  struct Shelf {
+    int y;
+    int height;
+    int x;
+  };
+
+  struct Page {
+    uint64_t id;
+    SDL_Texture *texture;
+    std::vector<Shelf> shelves;
+    uint64_t lastUsed;
+  };
+
+  struct Entry {
+    Glyph glyph;
+
+    // Zero for glyphs without a bitmap.
+    uint64_t page;
+  };
+
+  struct KeyHash {
+    size_t operator()(const AtlasKey &key) const;
+  };
+
+  bool Allocate(Page &page, const int &width, const int &height, int &x,
+                int &y);
+  Page CreatePage(SDL_Renderer *renderer);
+
+  std::vector<Page> pages;
+  std::unordered_map<AtlasKey, Entry, KeyHash> glyphs;
+
+  uint64_t frame{0};
+  uint64_t nextPageId{1};
+};
+
+#endif
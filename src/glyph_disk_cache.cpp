@@ -0,0 +1,62 @@
+#include "glyph_disk_cache.hpp"
+
+#include "font.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr RecordFile::Magic FILE_MAGIC{'F', 'R', 'T', 'G', 'L', 'Y', 'P', 'H'};
+constexpr uint32_t FILE_VERSION = 2;
+
+// Followed by the pixels.
+struct GlyphRecord {
+  int32_t width;
+  int32_t height;
+  int32_t boundX;
+  int32_t boundY;
+  int32_t advance;
+  int32_t reserved;
+};
+} // namespace
+
+GlyphDiskCache::GlyphDiskCache() : file(FILE_MAGIC, FILE_VERSION) {}
+
+std::optional<GlyphBitmap> GlyphDiskCache::Find(const GlyphCacheKey &key) {
+  auto payload = file.Find(AsBytes(key));
+  if (!payload.has_value() || payload->size() < sizeof(GlyphRecord))
+    return std::nullopt;
+
+  GlyphRecord record;
+  std::memcpy(&record, payload->data(), sizeof(record));
+
+  const auto pixelCount = payload->size() - sizeof(GlyphRecord);
+  if (record.width < 0 || record.height < 0 ||
+      pixelCount != static_cast<size_t>(record.width) * record.height)
+    return std::nullopt;
+
+  return GlyphBitmap{
+      .width = record.width,
+      .height = record.height,
+      .pixels = {payload->begin() + sizeof(GlyphRecord), payload->end()},
+      .bound = {record.boundX, record.boundY, record.width, record.height},
+      .advance = record.advance,
+  };
+}
+
+void GlyphDiskCache::Insert(const GlyphCacheKey &key,
+                            const GlyphBitmap &bitmap) {
+  const GlyphRecord record{
+      .width = bitmap.width,
+      .height = bitmap.height,
+      .boundX = bitmap.bound.x,
+      .boundY = bitmap.bound.y,
+      .advance = bitmap.advance,
+      .reserved = 0,
+  };
+
+  std::vector<uint8_t> payload(sizeof(record) + bitmap.pixels.size());
+  std::memcpy(payload.data(), &record, sizeof(record));
+  std::ranges::copy(bitmap.pixels, payload.begin() + sizeof(record));
+
+  file.Insert(AsBytes(key), payload);
+}
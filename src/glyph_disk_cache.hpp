@@ -0,0 +1,51 @@
+#ifndef GLYPH_DISK_CACHE_HPP
+#define GLYPH_DISK_CACHE_HPP
+
+#include "record_file.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+struct GlyphBitmap;
+
+struct GlyphCacheKey {
+  // Hash of the font file content.
+  uint64_t font{0};
+
+  // Hash of the variation axis values, 0 for the default instance.
+  uint64_t variation{0};
+
+  uint32_t size{0};
+  uint32_t glyph{0};
+  uint32_t renderMode{0};
+  uint32_t reserved{0};
+
+  bool operator==(const GlyphCacheKey &) const = default;
+};
+
+// Glyph bitmaps kept on disk between sessions.
+class GlyphDiskCache {
+public:
+  GlyphDiskCache();
+
+  bool Open(const std::filesystem::path &path, const size_t &maxSize) {
+    return file.Open(path, maxSize);
+  }
+  void Close() { file.Close(); }
+  bool IsOpen() const { return file.IsOpen(); }
+
+  std::optional<GlyphBitmap> Find(const GlyphCacheKey &key);
+  void Insert(const GlyphCacheKey &key, const GlyphBitmap &bitmap);
+
+  void Clear() { file.Clear(); }
+
+  size_t FileSize() const { return file.FileSize(); }
+  size_t RecordCount() const { return file.RecordCount(); }
+  size_t HitCount() const { return file.HitCount(); }
+  size_t MissCount() const { return file.MissCount(); }
+
+private:
+  RecordFile file;
+};
+
+#endif
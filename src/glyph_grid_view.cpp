@@ -0,0 +1,309 @@
+#include "glyph_grid_view.hpp"
+
+#include "colors.hpp"
+#include "draw_glyph.hpp"
+#include "frame_arena.hpp"
+#include "glyph_atlas.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <imgui.h>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+// Glyphs are rasterized in chunks of consecutive glyph indices.
+constexpr int CHUNK_SIZE = 64;
+
+constexpr int LABEL_HEIGHT = SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE + 4;
+constexpr float SCROLL_STEP = 48.0f;
+
+struct GridState {
+  int glyphSize{0};
+  magic_enum::containers::array<VariationAxis, float> axisValues{};
+
+  bool operator==(const GridState &) const = default;
+};
+
+struct ChunkOutput {
+  uint64_t generation{0};
+  std::vector<std::pair<uint32_t, GlyphBitmap>> bitmaps;
+};
+
+struct GridWorker {
+  std::unique_ptr<Font> font;
+
+  bool isAxisValuesSet{false};
+  magic_enum::containers::array<VariationAxis, float> axisValues{};
+};
+
+// A worker font with the chunk it is rasterizing, one per pool thread.
+struct Slot {
+  std::shared_ptr<GridWorker> worker{std::make_shared<GridWorker>()};
+  std::future<ChunkOutput> job;
+  int chunk{0};
+};
+
+std::vector<Slot> slots;
+std::vector<std::future<ChunkOutput>> retiredJobs;
+
+std::shared_ptr<const std::vector<char>> fontData;
+uint64_t fontHash = 0;
+GridState state{};
+
+// Changes with the font data or the state, so results of older jobs can be
+// told apart and dropped.
+uint64_t generation = 0;
+
+GlyphAtlas atlas;
+
+int glyphSize = 48;
+int memoryBudget = 64;
+
+float scroll = 0;
+float contentHeight = 0;
+float viewHeight = 0;
+
+int visibleFirst = 0;
+int visibleLast = 0;
+
+bool IsJobRunning(const Slot &slot) { return slot.job.valid(); }
+
+ChunkOutput RasterizeChunk(GridWorker &worker,
+                           const std::shared_ptr<const std::vector<char>> &data,
+                           const uint64_t &hash, const GridState &state,
+                           const uint64_t &generation, const int &first,
+                           const int &last) {
+  if (!worker.font || worker.font->Data() != data) {
+    worker.font = std::make_unique<Font>();
+    worker.font->Load(data, hash);
+    worker.isAxisValuesSet = false;
+  }
+
+  auto &font = *worker.font;
+  font.SetFontSize(state.glyphSize);
+  if (font.IsVariableFont() &&
+      (!worker.isAxisValuesSet || worker.axisValues != state.axisValues)) {
+    font.SetVariationValues(state.axisValues);
+    worker.axisValues = state.axisValues;
+    worker.isAxisValuesSet = true;
+  }
+
+  ChunkOutput output{.generation = generation};
+  output.bitmaps.reserve(last - first);
+
+  for (int index = first; index < last; index++) {
+    output.bitmaps.emplace_back(index, font.RasterizeGlyph(index));
+  }
+
+  return output;
+}
+
+void Reset(const Font &font, const GridState &newState) {
+  std::erase_if(retiredJobs, [](const auto &job) {
+    return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  });
+
+  for (auto &slot : slots) {
+    if (IsJobRunning(slot)) {
+      retiredJobs.push_back(std::move(slot.job));
+      slot.worker = std::make_shared<GridWorker>();
+    }
+  }
+
+  fontData = font.Data();
+  fontHash = font.ContentHash();
+  state = newState;
+  generation++;
+  atlas.Clear();
+}
+
+void CollectResults(SDL_Renderer *renderer) {
+  for (auto &slot : slots) {
+    if (!IsJobRunning(slot) || slot.job.wait_for(std::chrono::seconds(0)) !=
+                                   std::future_status::ready) {
+      continue;
+    }
+
+    auto output = slot.job.get();
+    if (output.generation != generation)
+      continue;
+
+    for (const auto &[index, bitmap] : output.bitmaps) {
+      atlas.Insert(renderer, {0, generation, index}, bitmap);
+    }
+  }
+}
+
+bool IsChunkPending(const int &chunk) {
+  return std::ranges::any_of(slots, [&chunk](const Slot &slot) {
+    return IsJobRunning(slot) && slot.chunk == chunk;
+  });
+}
+
+bool IsChunkComplete(const int &chunk, const int &glyphCount) {
+  const int last = std::min(glyphCount, (chunk + 1) * CHUNK_SIZE);
+  for (int index = chunk * CHUNK_SIZE; index < last; index++) {
+    if (!atlas.Contains({0, generation, static_cast<uint32_t>(index)}))
+      return false;
+  }
+
+  return true;
+}
+
+/*
+ * Hands the chunks between `first` and `last` that are missing glyphs to
+ * idle workers, in order. Returns false when there are no idle workers left.
+ */
+bool ScheduleChunks(const int &first, const int &last, const int &glyphCount) {
+  for (int chunk = first / CHUNK_SIZE; chunk * CHUNK_SIZE < last; chunk++) {
+    if (IsChunkPending(chunk) || IsChunkComplete(chunk, glyphCount))
+      continue;
+
+    auto slot = std::ranges::find_if(
+        slots, [](const Slot &slot) { return !IsJobRunning(slot); });
+    if (slot == slots.end())
+      return false;
+
+    const int chunkFirst = chunk * CHUNK_SIZE;
+    const int chunkLast = std::min(glyphCount, chunkFirst + CHUNK_SIZE);
+
+    slot->chunk = chunk;
+    slot->job = ThreadPool::Shared().Submit(
+        [worker = slot->worker, data = fontData, hash = fontHash,
+         state = state, generation = generation, chunkFirst, chunkLast]() {
+          return RasterizeChunk(*worker, data, hash, state, generation,
+                                chunkFirst, chunkLast);
+        });
+  }
+
+  return true;
+}
+} // namespace
+
+void GlyphGridTick(
+    SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
+    const magic_enum::containers::array<VariationAxis, float> &axisValues,
+    const SDL_Color &color) {
+  if (!font.IsValid())
+    return;
+
+  if (slots.empty()) {
+    slots.resize(ThreadPool::Shared().ThreadCount());
+  }
+
+  const GridState newState{
+      .glyphSize = glyphSize,
+      .axisValues = axisValues,
+  };
+  if (font.Data() != fontData || newState != state) {
+    Reset(font, newState);
+  }
+
+  CollectResults(renderer);
+  atlas.NextFrame();
+
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  const int cellWidth = glyphSize * 3 / 2;
+  const int cellHeight = cellWidth + LABEL_HEIGHT;
+  const int columns = std::max(1, bound.w / cellWidth);
+  const int glyphCount = font.GlyphCount();
+  const int rows = (glyphCount + columns - 1) / columns;
+
+  contentHeight = static_cast<float>(rows * cellHeight);
+  viewHeight = static_cast<float>(bound.h);
+
+  const int firstRow = static_cast<int>(scroll) / cellHeight;
+  const int lastRow =
+      std::min(rows, static_cast<int>(scroll + bound.h) / cellHeight + 1);
+
+  visibleFirst = firstRow * columns;
+  visibleLast = std::min(glyphCount, lastRow * columns);
+
+  std::pmr::vector<SDL_FRect> borders(FrameArena::Shared().Resource());
+  borders.reserve(visibleLast - visibleFirst);
+
+  DebugOverlay overlay(renderer, debug);
+
+  for (int index = visibleFirst; index < visibleLast; index++) {
+    const float left = static_cast<float>((index % columns) * cellWidth);
+    const float top = (index / columns) * cellHeight - scroll;
+
+    borders.push_back({left, top, static_cast<float>(cellWidth),
+                       static_cast<float>(cellHeight)});
+
+    auto g = atlas.Find({0, generation, static_cast<uint32_t>(index)});
+    if (g != nullptr && g->texture != nullptr) {
+      const float x = left + (cellWidth - g->advance) / 2.0f;
+      const float baseline = bound.h - (top + cellWidth * 0.75f);
+
+      DrawGlyph(renderer, overlay, *g, color, x, baseline);
+    }
+
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderDebugText(renderer, left + 2, top + cellWidth,
+                        std::to_string(index).c_str());
+  }
+
+  SDL_SetRenderDrawColor(renderer, glyphGridBorderColor.r,
+                         glyphGridBorderColor.g, glyphGridBorderColor.b,
+                         glyphGridBorderColor.a);
+  SDL_RenderRects(renderer, borders.data(), static_cast<int>(borders.size()));
+
+  // The screen first, then one screen ahead.
+  const int prefetchLast =
+      std::min(glyphCount, visibleLast + (visibleLast - visibleFirst));
+  if (ScheduleChunks(visibleFirst, visibleLast, glyphCount)) {
+    ScheduleChunks(visibleLast, prefetchLast, glyphCount);
+  }
+
+  const size_t budget = static_cast<size_t>(memoryBudget) * 1024 * 1024;
+  while (atlas.MemorySize() > budget && atlas.EvictPage()) {
+  }
+}
+
+void GlyphGridDoUI() {
+  auto &io = ImGui::GetIO();
+  if (!io.WantCaptureMouse) {
+    scroll -= io.MouseWheel * SCROLL_STEP;
+  }
+  scroll = std::clamp(scroll, 0.0f, std::max(0.0f, contentHeight - viewHeight));
+
+  if (ImGui::Begin("Glyph grid")) {
+    ImGui::SliderInt("Glyph size##grid", &glyphSize, 16, 256);
+    ImGui::SliderInt("Memory budget (MiB)##grid", &memoryBudget, 16, 512);
+    ImGui::SliderFloat("Scroll##grid", &scroll, 0.0f,
+                       std::max(0.0f, contentHeight - viewHeight), "%.0f");
+
+    const auto pending = std::ranges::count_if(slots, IsJobRunning);
+
+    ImGui::LabelText("On screen", "%d - %d", visibleFirst, visibleLast);
+    ImGui::LabelText("Pending chunks", "%td", pending);
+    ImGui::LabelText("Atlas", "%zu glyphs, %zu pages (%.1f MiB)",
+                     atlas.GlyphCount(), atlas.PageCount(),
+                     atlas.MemorySize() / (1024.0 * 1024.0));
+  }
+  ImGui::End();
+}
+
+void GlyphGridCleanUp() {
+  for (auto &slot : slots) {
+    if (IsJobRunning(slot)) {
+      slot.job.wait();
+    }
+  }
+  for (auto &job : retiredJobs) {
+    job.wait();
+  }
+
+  retiredJobs.clear();
+  slots.clear();
+  fontData.reset();
+  atlas.Clear();
+}
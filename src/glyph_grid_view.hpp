@@ -0,0 +1,23 @@
+#ifndef GLYPH_GRID_VIEW_HPP
+#define GLYPH_GRID_VIEW_HPP
+
+#include "debug_settings.hpp"
+#include "font.hpp"
+#include <SDL3/SDL.h>
+#include <magic_enum/magic_enum_containers.hpp>
+
+/*
+ * Shows every glyph of the font in a scrolling grid. Only the rows on screen,
+ * and one screen below them, are rasterized, and atlas pages that have not
+ * been on screen for a while are evicted to stay under a memory budget.
+ */
+void GlyphGridTick(
+    SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
+    const magic_enum::containers::array<VariationAxis, float> &axisValues,
+    const SDL_Color &color);
+
+void GlyphGridDoUI();
+
+void GlyphGridCleanUp();
+
+#endif
@@ -0,0 +1,306 @@
+#include "glyph_outline.hpp"
+
+#include "colors.hpp"
+#include "frame_arena.hpp"
+#include <algorithm>
+#include <cmath>
+
+#include FT_OUTLINE_H
+
+namespace {
+constexpr int MAX_CURVE_SEGMENTS = 64;
+
+// Band edges closer than this are merged, in font units.
+constexpr float EPSILON = 1e-3f;
+
+struct Flattener {
+  float tolerance{1};
+  std::vector<std::vector<SDL_FPoint>> contours;
+};
+
+struct Edge {
+  float x0;
+  float y0;
+  float x1;
+  float y1;
+
+  // +1 going up, -1 going down.
+  int winding;
+
+  float XAt(const float &y) const {
+    return x0 + (x1 - x0) * (y - y0) / (y1 - y0);
+  }
+};
+
+SDL_FPoint ToPoint(const FT_Vector *v) {
+  return {static_cast<float>(v->x), static_cast<float>(v->y)};
+}
+
+float Distance(const SDL_FPoint &p) { return std::hypot(p.x, p.y); }
+
+// Uniform steps, as many as needed for the chords to stay within the
+// tolerance given the second derivative of the curve.
+int SegmentCount(const float &error) {
+  return std::clamp(static_cast<int>(std::ceil(std::sqrt(error))), 1,
+                    MAX_CURVE_SEGMENTS);
+}
+
+int MoveTo(const FT_Vector *to, void *user) {
+  auto &flattener = *static_cast<Flattener *>(user);
+  flattener.contours.emplace_back().push_back(ToPoint(to));
+
+  return 0;
+}
+
+int LineTo(const FT_Vector *to, void *user) {
+  auto &flattener = *static_cast<Flattener *>(user);
+  flattener.contours.back().push_back(ToPoint(to));
+
+  return 0;
+}
+
+int ConicTo(const FT_Vector *control, const FT_Vector *to, void *user) {
+  auto &flattener = *static_cast<Flattener *>(user);
+  auto &contour = flattener.contours.back();
+
+  const auto p0 = contour.back();
+  const auto p1 = ToPoint(control);
+  const auto p2 = ToPoint(to);
+
+  const float dd =
+      Distance({p0.x - 2 * p1.x + p2.x, p0.y - 2 * p1.y + p2.y});
+  const int count = SegmentCount(dd / (4 * flattener.tolerance));
+
+  for (int i = 1; i <= count; i++) {
+    const float t = static_cast<float>(i) / count;
+    const float u = 1 - t;
+    contour.push_back({
+        u * u * p0.x + 2 * u * t * p1.x + t * t * p2.x,
+        u * u * p0.y + 2 * u * t * p1.y + t * t * p2.y,
+    });
+  }
+
+  return 0;
+}
+
+int CubicTo(const FT_Vector *control1, const FT_Vector *control2,
+            const FT_Vector *to, void *user) {
+  auto &flattener = *static_cast<Flattener *>(user);
+  auto &contour = flattener.contours.back();
+
+  const auto p0 = contour.back();
+  const auto p1 = ToPoint(control1);
+  const auto p2 = ToPoint(control2);
+  const auto p3 = ToPoint(to);
+
+  const float dd =
+      std::max(Distance({p0.x - 2 * p1.x + p2.x, p0.y - 2 * p1.y + p2.y}),
+               Distance({p1.x - 2 * p2.x + p3.x, p1.y - 2 * p2.y + p3.y}));
+  const int count = SegmentCount(3 * dd / (4 * flattener.tolerance));
+
+  for (int i = 1; i <= count; i++) {
+    const float t = static_cast<float>(i) / count;
+    const float u = 1 - t;
+    contour.push_back({
+        u * u * u * p0.x + 3 * u * u * t * p1.x + 3 * u * t * t * p2.x +
+            t * t * t * p3.x,
+        u * u * u * p0.y + 3 * u * u * t * p1.y + 3 * u * t * t * p2.y +
+            t * t * t * p3.y,
+    });
+  }
+
+  return 0;
+}
+
+std::vector<Edge> CollectEdges(const Flattener &flattener) {
+  std::vector<Edge> edges;
+
+  for (const auto &contour : flattener.contours) {
+    for (size_t i = 0; i < contour.size(); i++) {
+      const auto &a = contour[i];
+      const auto &b = contour[(i + 1) % contour.size()];
+
+      // Horizontal edges do not change the winding of any span.
+      if (a.y == b.y)
+        continue;
+
+      if (a.y < b.y) {
+        edges.push_back({a.x, a.y, b.x, b.y, 1});
+      } else {
+        edges.push_back({b.x, b.y, a.x, a.y, -1});
+      }
+    }
+  }
+
+  std::ranges::sort(edges, {}, &Edge::y0);
+
+  return edges;
+}
+
+// Every vertex, and every point where two edges cross.
+std::vector<float> BandEdges(const std::vector<Edge> &edges) {
+  std::vector<float> output;
+
+  for (size_t i = 0; i < edges.size(); i++) {
+    const auto &a = edges[i];
+    output.push_back(a.y0);
+    output.push_back(a.y1);
+
+    for (size_t j = i + 1; j < edges.size() && edges[j].y0 < a.y1; j++) {
+      const auto &b = edges[j];
+
+      const float low = std::max(a.y0, b.y0);
+      const float high = std::min(a.y1, b.y1);
+      if (high - low <= EPSILON)
+        continue;
+
+      const float dLow = a.XAt(low) - b.XAt(low);
+      const float dHigh = a.XAt(high) - b.XAt(high);
+      if ((dLow < 0 && dHigh > 0) || (dLow > 0 && dHigh < 0)) {
+        output.push_back(low + (high - low) * dLow / (dLow - dHigh));
+      }
+    }
+  }
+
+  std::ranges::sort(output);
+  const auto duplicates = std::ranges::unique(
+      output, [](const float &a, const float &b) { return b - a < EPSILON; });
+  output.erase(duplicates.begin(), duplicates.end());
+
+  return output;
+}
+} // namespace
+
+GlyphOutline TessellateOutline(const FT_Outline &outline,
+                               const float &tolerance) {
+  GlyphOutline output;
+
+  Flattener flattener{.tolerance = std::max(tolerance, EPSILON)};
+
+  const FT_Outline_Funcs funcs{
+      .move_to = MoveTo,
+      .line_to = LineTo,
+      .conic_to = ConicTo,
+      .cubic_to = CubicTo,
+      .shift = 0,
+      .delta = 0,
+  };
+  FT_Outline_Decompose(const_cast<FT_Outline *>(&outline), &funcs, &flattener);
+
+  bool isFirst = true;
+  for (const auto &contour : flattener.contours) {
+    for (const auto &p : contour) {
+      output.xMin = isFirst ? p.x : std::min(output.xMin, p.x);
+      output.yMin = isFirst ? p.y : std::min(output.yMin, p.y);
+      output.xMax = isFirst ? p.x : std::max(output.xMax, p.x);
+      output.yMax = isFirst ? p.y : std::max(output.yMax, p.y);
+      isFirst = false;
+    }
+  }
+
+  const auto edges = CollectEdges(flattener);
+  const auto bands = BandEdges(edges);
+
+  std::vector<const Edge *> active;
+  std::vector<float> bottoms;
+  std::vector<float> tops;
+  std::vector<size_t> order;
+  size_t nextEdge = 0;
+
+  for (size_t b = 0; b + 1 < bands.size(); b++) {
+    const float bottom = bands[b];
+    const float top = bands[b + 1];
+
+    std::erase_if(active, [&bottom](const Edge *e) {
+      return e->y1 <= bottom + EPSILON;
+    });
+    while (nextEdge < edges.size() && edges[nextEdge].y0 < top - EPSILON) {
+      if (edges[nextEdge].y1 > bottom + EPSILON) {
+        active.push_back(&edges[nextEdge]);
+      }
+      nextEdge++;
+    }
+
+    const float middle = (bottom + top) / 2;
+
+    order.resize(active.size());
+    bottoms.resize(active.size());
+    tops.resize(active.size());
+    for (size_t i = 0; i < active.size(); i++) {
+      order[i] = i;
+      bottoms[i] = active[i]->XAt(bottom);
+      tops[i] = active[i]->XAt(top);
+    }
+
+    // Edges do not cross inside the band, so the middle gives their order.
+    std::ranges::sort(order, {}, [&active, &middle](const size_t &i) {
+      return active[i]->XAt(middle);
+    });
+
+    int winding = 0;
+    size_t left = 0;
+    for (const auto &i : order) {
+      const int previous = winding;
+      winding += active[i]->winding;
+
+      if (previous == 0 && winding != 0) {
+        left = i;
+      } else if (previous != 0 && winding == 0) {
+        const auto first = static_cast<int>(output.vertices.size());
+
+        output.vertices.push_back({bottoms[left], bottom});
+        output.vertices.push_back({bottoms[i], bottom});
+        output.vertices.push_back({tops[i], top});
+        output.vertices.push_back({tops[left], top});
+
+        for (const auto &index : {0, 1, 2, 0, 2, 3}) {
+          output.indices.push_back(first + index);
+        }
+      }
+    }
+  }
+
+  return output;
+}
+
+OutlineBatch::OutlineBatch(SDL_Renderer *renderer)
+    : renderer(renderer), vertices(FrameArena::Shared().Resource()),
+      indices(FrameArena::Shared().Resource()) {
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  height = static_cast<float>(bound.h);
+}
+
+OutlineBatch::~OutlineBatch() { Flush(); }
+
+void OutlineBatch::Add(const GlyphOutline &outline, const float &x,
+                       const float &y, const float &scale,
+                       const SDL_Color &color) {
+  const auto f4 = SDLColorToFloat4(color);
+  const SDL_FColor fColor{f4[0], f4[1], f4[2], f4[3]};
+  const auto first = static_cast<int>(vertices.size());
+
+  for (const auto &v : outline.vertices) {
+    vertices.push_back({
+        .position = {x + v.x * scale, height - (y + v.y * scale)},
+        .color = fColor,
+        .tex_coord = {0, 0},
+    });
+  }
+
+  for (const auto &index : outline.indices) {
+    indices.push_back(first + index);
+  }
+}
+
+void OutlineBatch::Flush() {
+  if (indices.empty())
+    return;
+
+  SDL_RenderGeometry(renderer, nullptr, vertices.data(),
+                     static_cast<int>(vertices.size()), indices.data(),
+                     static_cast<int>(indices.size()));
+  vertices.clear();
+  indices.clear();
+}
@@ -0,0 +1,63 @@
+#ifndef GLYPH_OUTLINE_HPP
+#define GLYPH_OUTLINE_HPP
+
+#include <SDL3/SDL.h>
+#include <memory_resource>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// A glyph outline cut into triangles, in font units with the Y axis going up.
+// It does not depend on the size, only on the glyph and the variation.
+struct GlyphOutline {
+  std::vector<SDL_FPoint> vertices;
+  std::vector<int> indices;
+
+  // The bounding box of the outline.
+  float xMin{0};
+  float yMin{0};
+  float xMax{0};
+  float yMax{0};
+
+  float advance{0};
+};
+
+/*
+ * Flattens the curves of `outline` into segments no further than `tolerance`
+ * from the curve, then fills it with the non-zero winding rule: the outline
+ * is cut into horizontal bands at every vertex and every edge crossing, so
+ * inside a band the edges never cross and each filled span is a trapezoid.
+ */
+GlyphOutline TessellateOutline(const FT_Outline &outline,
+                               const float &tolerance);
+
+/*
+ * Collects the triangles of the outlines drawn in a frame and submits them in
+ * one call. Like the Draw functions, positions have their origin in the
+ * bottom-left corner of the viewport.
+ */
+class OutlineBatch {
+public:
+  explicit OutlineBatch(SDL_Renderer *renderer);
+  OutlineBatch(const OutlineBatch &) = delete;
+  OutlineBatch &operator=(const OutlineBatch &) = delete;
+
+  // Draws what was not flushed yet.
+  ~OutlineBatch();
+
+  // `scale` converts font units to pixels, (x, y) is the glyph origin.
+  void Add(const GlyphOutline &outline, const float &x, const float &y,
+           const float &scale, const SDL_Color &color);
+
+  void Flush();
+
+private:
+  SDL_Renderer *renderer;
+  float height{0};
+
+  std::pmr::vector<SDL_Vertex> vertices;
+  std::pmr::vector<int> indices;
+};
+
+#endif
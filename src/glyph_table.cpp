@@ -0,0 +1,170 @@
+#include "glyph_table.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <map>
+#include <random>
+
+namespace {
+constexpr size_t MIN_HASH_SLOTS = 256;
+
+// Fibonacci hashing, glyph indices are mostly small and sequential.
+constexpr uint32_t HASH_MULTIPLIER = 2654435769u;
+
+template <class F>
+double TimePerLookup(const std::vector<uint32_t> &lookups, F &&find) {
+  const auto start = std::chrono::steady_clock::now();
+
+  // Summed so the lookups are not optimized away.
+  int sum = 0;
+  for (const auto &index : lookups) {
+    sum += find(index);
+  }
+
+  const std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  static volatile int sink;
+  sink = sum;
+
+  return elapsed.count() / static_cast<double>(lookups.size());
+}
+} // namespace
+
+void GlyphTable::Reset(const size_t &glyphCount) {
+  glyphs.clear();
+  keys.clear();
+
+  isDense = glyphCount > 0 && glyphCount <= DENSE_LIMIT;
+  slots.assign(isDense ? glyphCount : MIN_HASH_SLOTS, EMPTY);
+}
+
+void GlyphTable::Clear() {
+  glyphs.clear();
+  keys.clear();
+  std::ranges::fill(slots, EMPTY);
+
+  if (slots.empty()) {
+    slots.assign(MIN_HASH_SLOTS, EMPTY);
+  }
+}
+
+Glyph *GlyphTable::Find(const uint32_t &index) {
+  if (isDense) {
+    if (index >= slots.size() || slots[index] == EMPTY)
+      return nullptr;
+
+    return &glyphs[slots[index]];
+  }
+
+  if (slots.empty())
+    return nullptr;
+
+  const size_t mask = slots.size() - 1;
+  for (size_t slot = HashSlot(index);; slot = (slot + 1) & mask) {
+    if (slots[slot] == EMPTY)
+      return nullptr;
+
+    if (keys[slots[slot]] == index)
+      return &glyphs[slots[slot]];
+  }
+}
+
+Glyph &GlyphTable::Insert(const uint32_t &index, const Glyph &glyph) {
+  if (auto found = Find(index)) {
+    *found = glyph;
+    return *found;
+  }
+
+  // Out of range for the dense layout, e.g. a broken glyph count.
+  if (isDense && index >= slots.size()) {
+    slots.resize(static_cast<size_t>(index) + 1, EMPTY);
+  }
+
+  // Kept at most half full, so probes stay short.
+  if (!isDense && (glyphs.size() + 1) * 2 > slots.size()) {
+    Grow();
+  }
+
+  const auto position = static_cast<uint32_t>(glyphs.size());
+  glyphs.push_back(glyph);
+  keys.push_back(index);
+
+  if (isDense) {
+    slots[index] = position;
+  } else {
+    const size_t mask = slots.size() - 1;
+    size_t slot = HashSlot(index);
+    while (slots[slot] != EMPTY) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = position;
+  }
+
+  return glyphs.back();
+}
+
+size_t GlyphTable::HashSlot(const uint32_t &index) const {
+  const auto bits = std::countr_zero(slots.size());
+  return bits == 0 ? 0 : (index * HASH_MULTIPLIER) >> (32 - bits);
+}
+
+void GlyphTable::Grow() {
+  slots.assign(std::max(MIN_HASH_SLOTS, slots.size() * 2), EMPTY);
+
+  const size_t mask = slots.size() - 1;
+  for (uint32_t position = 0; position < keys.size(); position++) {
+    size_t slot = HashSlot(keys[position]);
+    while (slots[slot] != EMPTY) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = position;
+  }
+}
+
+GlyphLookupBenchmark RunGlyphLookupBenchmark(const size_t &glyphCount,
+                                             const size_t &lookupCount) {
+  GlyphLookupBenchmark output{
+      .glyphCount = glyphCount,
+      .lookupCount = lookupCount,
+  };
+
+  if (glyphCount == 0 || lookupCount == 0)
+    return output;
+
+  std::map<unsigned int, Glyph> map;
+  GlyphTable dense;
+  GlyphTable hashed;
+  dense.Reset(glyphCount);
+  hashed.Reset(0);
+
+  for (uint32_t i = 0; i < glyphCount; i++) {
+    const Glyph glyph{.advance = static_cast<int>(i)};
+    map.insert({i, glyph});
+    dense.Insert(i, glyph);
+    hashed.Insert(i, glyph);
+  }
+
+  // Same sequence every run, so the results can be compared.
+  std::mt19937 random(42);
+  std::uniform_int_distribution<uint32_t> distribution(
+      0, static_cast<uint32_t>(glyphCount - 1));
+
+  std::vector<uint32_t> lookups(lookupCount);
+  for (auto &index : lookups) {
+    index = distribution(random);
+  }
+
+  output.mapNs = TimePerLookup(lookups, [&map](const uint32_t &index) {
+    return map.find(index)->second.advance;
+  });
+  output.denseNs = TimePerLookup(lookups, [&dense](const uint32_t &index) {
+    return dense.Find(index)->advance;
+  });
+  output.hashNs = TimePerLookup(lookups, [&hashed](const uint32_t &index) {
+    return hashed.Find(index)->advance;
+  });
+
+  return output;
+}
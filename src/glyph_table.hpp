@@ -0,0 +1,81 @@
+#ifndef GLYPH_TABLE_HPP
+#define GLYPH_TABLE_HPP
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Glyph {
+  SDL_Texture *texture{nullptr};
+  SDL_Rect bound{};
+  int advance = 0;
+
+  // The area of `texture` holding the glyph, when the texture is an atlas
+  // page. An empty rectangle means the whole texture.
+  SDL_FRect source{};
+};
+
+/*
+ * The glyphs of a font by glyph index, stored next to each other. Fonts with
+ * up to DENSE_LIMIT glyphs, which covers every OpenType font, map the index
+ * to its slot through a plain array. Larger or unknown glyph counts fall back
+ * to an open-addressing table with linear probing.
+ *
+ * Inserting may move the glyphs, so references are only valid until the next
+ * insertion.
+ */
+class GlyphTable {
+public:
+  static constexpr size_t DENSE_LIMIT = 65536;
+
+  // Drops every glyph and picks the layout for a font of `glyphCount` glyphs,
+  // 0 when unknown.
+  void Reset(const size_t &glyphCount);
+
+  // Drops every glyph, keeping the layout.
+  void Clear();
+
+  Glyph *Find(const uint32_t &index);
+  Glyph &Insert(const uint32_t &index, const Glyph &glyph);
+
+  size_t Size() const { return glyphs.size(); }
+  bool IsDense() const { return isDense; }
+
+  std::vector<Glyph>::iterator begin() { return glyphs.begin(); }
+  std::vector<Glyph>::iterator end() { return glyphs.end(); }
+
+private:
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  size_t HashSlot(const uint32_t &index) const;
+  void Grow();
+
+  bool isDense{false};
+
+  std::vector<Glyph> glyphs;
+
+  // Glyph index of each element of `glyphs`.
+  std::vector<uint32_t> keys;
+
+  // Position in `glyphs`, or EMPTY. Indexed by glyph index in the dense
+  // layout, by hash otherwise, with a power of two size.
+  std::vector<uint32_t> slots;
+};
+
+struct GlyphLookupBenchmark {
+  size_t glyphCount{0};
+  size_t lookupCount{0};
+
+  // Average time of one lookup.
+  double mapNs{0};
+  double denseNs{0};
+  double hashNs{0};
+};
+
+// Times random lookups of `glyphCount` cached glyphs in a std::map and in
+// both layouts of the table.
+GlyphLookupBenchmark RunGlyphLookupBenchmark(const size_t &glyphCount,
+                                             const size_t &lookupCount);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * XXH64 (https://github.com/Cyan4973/xxHash). Used to identify font files and
+ * to detect corrupted records in the on-disk caches, so it must give the same
+ * value on every run and platform.
+ */
+uint64_t Hash64(const void *data, const size_t &size, const uint64_t &seed = 0);
+
+#endif
@@ -0,0 +1,227 @@
+#include "itemizer.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <unicode/ubidi.h>
+#include <unicode/utf16.h>
+
+namespace {
+struct ScriptLanguages {
+  hb_script_t script;
+
+  // The first entry is used when the selected language does not match.
+  std::vector<std::string_view> languages;
+};
+
+const std::vector<ScriptLanguages> scriptLanguages{
+    {HB_SCRIPT_THAI, {"th"}},
+    {HB_SCRIPT_ARABIC, {"ar", "fa", "ur"}},
+    {HB_SCRIPT_HEBREW, {"he", "yi"}},
+    {HB_SCRIPT_HANGUL, {"ko"}},
+    {HB_SCRIPT_HIRAGANA, {"ja"}},
+    {HB_SCRIPT_KATAKANA, {"ja"}},
+    {HB_SCRIPT_HAN, {"zh", "ja", "ko"}},
+};
+
+struct Span {
+  size_t offset;
+  size_t length;
+};
+
+struct ScriptSpan : Span {
+  hb_script_t script;
+};
+
+struct LevelSpan : Span {
+  UBiDiLevel level;
+};
+
+bool IsWeakScript(const hb_script_t &script) {
+  return script == HB_SCRIPT_COMMON || script == HB_SCRIPT_INHERITED ||
+         script == HB_SCRIPT_UNKNOWN;
+}
+
+/*
+ * Characters of the Common and Inherited scripts (spaces, punctuation,
+ * combining marks) take the script of the run they are in. Leading weak
+ * characters are attached to the first strong script that follows them.
+ */
+std::vector<ScriptSpan> SplitScripts(std::u16string_view text) {
+  auto funcs = hb_unicode_funcs_get_default();
+
+  std::vector<ScriptSpan> spans;
+  hb_script_t current = HB_SCRIPT_COMMON;
+  size_t start = 0;
+
+  size_t i = 0;
+  while (i < text.size()) {
+    const size_t position = i;
+
+    UChar32 cp;
+    U16_NEXT(text.data(), i, text.size(), cp);
+
+    const auto script = hb_unicode_script(funcs, cp);
+    if (IsWeakScript(script)) {
+      continue;
+    }
+
+    if (IsWeakScript(current)) {
+      current = script;
+      continue;
+    }
+
+    if (script != current) {
+      spans.push_back({{start, position - start}, current});
+      start = position;
+      current = script;
+    }
+  }
+
+  if (start < text.size()) {
+    spans.push_back({{start, text.size() - start}, current});
+  }
+
+  return spans;
+}
+
+std::vector<LevelSpan> SplitLevels(std::u16string_view text,
+                                   const hb_direction_t &baseDirection) {
+  const UBiDiLevel paragraphLevel = baseDirection == HB_DIRECTION_RTL ? 1 : 0;
+  const std::vector<LevelSpan> fallback{{{0, text.size()}, paragraphLevel}};
+
+  if (HB_DIRECTION_IS_VERTICAL(baseDirection)) {
+    return fallback;
+  }
+
+  UErrorCode error = U_ZERO_ERROR;
+  UBiDi *bidi = ubidi_openSized(static_cast<int32_t>(text.size()), 0, &error);
+
+  ubidi_setPara(bidi, reinterpret_cast<const UChar *>(text.data()),
+                static_cast<int32_t>(text.size()), paragraphLevel, nullptr,
+                &error);
+
+  if (U_FAILURE(error)) {
+    spdlog::error("Unable to resolve bidi levels: {}", u_errorName(error));
+    ubidi_close(bidi);
+
+    return fallback;
+  }
+
+  std::vector<LevelSpan> spans;
+  int32_t start = 0;
+  const int32_t length = ubidi_getLength(bidi);
+
+  while (start < length) {
+    int32_t limit;
+    UBiDiLevel level;
+    ubidi_getLogicalRun(bidi, start, &limit, &level);
+
+    spans.push_back({{static_cast<size_t>(start),
+                      static_cast<size_t>(limit - start)},
+                     level});
+    start = limit;
+  }
+
+  ubidi_close(bidi);
+
+  return spans;
+}
+} // namespace
+
+hb_language_t LanguageForScript(const hb_script_t &script,
+                                const std::string &language) {
+  auto it = std::ranges::find(scriptLanguages, script, &ScriptLanguages::script);
+
+  if (it == scriptLanguages.end()) {
+    if (language.empty())
+      return HB_LANGUAGE_INVALID;
+
+    return hb_language_from_string(language.c_str(), language.length());
+  }
+
+  auto primary = std::string_view(language).substr(0, language.find('-'));
+  if (std::ranges::find(it->languages, primary) != it->languages.end()) {
+    return hb_language_from_string(language.c_str(), language.length());
+  }
+
+  const auto &fallback = it->languages.front();
+  return hb_language_from_string(fallback.data(), fallback.length());
+}
+
+std::vector<TextRun> ItemizeParagraph(std::u16string_view text,
+                                      const hb_direction_t &baseDirection,
+                                      const hb_script_t &script,
+                                      const std::string &language) {
+  if (text.empty())
+    return {};
+
+  const auto scriptSpans =
+      script == HB_SCRIPT_INVALID
+          ? SplitScripts(text)
+          : std::vector<ScriptSpan>{{{0, text.size()}, script}};
+
+  const auto levelSpans = SplitLevels(text, baseDirection);
+
+  std::vector<TextRun> runs;
+  auto scriptIt = scriptSpans.begin();
+  auto levelIt = levelSpans.begin();
+  size_t start = 0;
+
+  // Both span lists cover the whole paragraph, so walk them together and cut
+  // a run wherever either of them changes.
+  while (scriptIt != scriptSpans.end() && levelIt != levelSpans.end()) {
+    const size_t scriptEnd = scriptIt->offset + scriptIt->length;
+    const size_t levelEnd = levelIt->offset + levelIt->length;
+    const size_t end = std::min(scriptEnd, levelEnd);
+
+    hb_direction_t direction = baseDirection;
+    if (HB_DIRECTION_IS_HORIZONTAL(baseDirection)) {
+      direction = (levelIt->level & 1) ? HB_DIRECTION_RTL : HB_DIRECTION_LTR;
+    }
+
+    runs.push_back({
+        .offset = start,
+        .length = end - start,
+        .script = scriptIt->script,
+        .direction = direction,
+        .language = LanguageForScript(scriptIt->script, language),
+        .level = levelIt->level,
+    });
+
+    start = end;
+    if (scriptEnd == end)
+      scriptIt++;
+    if (levelEnd == end)
+      levelIt++;
+  }
+
+  return runs;
+}
+
+std::vector<int32_t> VisualRunOrder(const std::vector<uint8_t> &levels) {
+  std::vector<int32_t> visualMap(levels.size());
+  ubidi_reorderVisual(levels.data(), static_cast<int32_t>(levels.size()),
+                      visualMap.data());
+
+  return visualMap;
+}
+
+void ReorderRuns(std::vector<TextRun> &runs) {
+  if (runs.size() < 2)
+    return;
+
+  std::vector<UBiDiLevel> levels;
+  levels.reserve(runs.size());
+  std::ranges::transform(runs, std::back_inserter(levels), &TextRun::level);
+
+  const auto visualMap = VisualRunOrder(levels);
+
+  std::vector<TextRun> reordered;
+  reordered.reserve(runs.size());
+  for (const auto &logicalIndex : visualMap) {
+    reordered.push_back(runs[logicalIndex]);
+  }
+
+  runs = std::move(reordered);
+}
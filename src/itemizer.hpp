@@ -0,0 +1,46 @@
+#ifndef ITEMIZER_HPP
+#define ITEMIZER_HPP
+
+#include <cstdint>
+#include <harfbuzz/hb.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * A run is the longest span of a paragraph that shares the same script, bidi
+ * level and language, so it can be handed to HarfBuzz as a single buffer.
+ * Offsets and lengths are in UTF-16 code units, relative to the paragraph.
+ */
+struct TextRun {
+  size_t offset{0};
+  size_t length{0};
+  hb_script_t script{HB_SCRIPT_COMMON};
+  hb_direction_t direction{HB_DIRECTION_LTR};
+  hb_language_t language{HB_LANGUAGE_INVALID};
+  uint8_t level{0};
+};
+
+/*
+ * Split a paragraph (a line without '\n') into runs in logical order.
+ *
+ * Pass HB_SCRIPT_INVALID as `script` to detect the script of each character,
+ * or any other value to force every run into that script. An empty `language`
+ * lets each run pick the default language of its script.
+ */
+std::vector<TextRun> ItemizeParagraph(std::u16string_view text,
+                                      const hb_direction_t &baseDirection,
+                                      const hb_script_t &script,
+                                      const std::string &language);
+
+// Reorder runs of a single line from logical order into visual order (UAX #9
+// rule L2).
+void ReorderRuns(std::vector<TextRun> &runs);
+
+// Visual to logical index map for runs with the given bidi levels.
+std::vector<int32_t> VisualRunOrder(const std::vector<uint8_t> &levels);
+
+hb_language_t LanguageForScript(const hb_script_t &script,
+                                const std::string &language);
+
+#endif
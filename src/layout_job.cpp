@@ -0,0 +1,89 @@
+#include "layout_job.hpp"
+
+#include "draw_glyph.hpp"
+
+LayoutJobOutput RunLayoutJob(LayoutWorker &worker, const LayoutJobInput &input,
+                             const bool &isAtlasStale) {
+  const auto start = std::chrono::steady_clock::now();
+
+  LayoutJobOutput output;
+
+  if (!worker.font || !worker.font->IsValid()) {
+    output.elapsed = std::chrono::steady_clock::now() - start;
+    return output;
+  }
+
+  auto &font = *worker.font;
+  font.SetFontSize(input.fontSize);
+  font.SetRenderMode(input.renderMode);
+
+  if (input.isAxisValuesSet && font.IsVariableFont() &&
+      (!worker.isAxisValuesSet || worker.axisValues != input.axisValues)) {
+    font.SetVariationValues(input.axisValues);
+    worker.axisValues = input.axisValues;
+    worker.isAxisValuesSet = true;
+  }
+
+  worker.layout.Update(font, input.text, input.options, input.extent);
+
+  if (isAtlasStale || worker.rasterizedGeneration != font.Generation()) {
+    worker.rasterized.clear();
+    worker.rasterizedGeneration = font.Generation();
+  }
+
+  for (const auto &paragraph : worker.layout.Paragraphs()) {
+    for (const auto &line : paragraph.lines) {
+      for (const auto &run : line.runs) {
+        for (size_t i = run.glyphStart; i < run.glyphEnd; i++) {
+          const auto index = run.shaped->glyphs[i].index;
+          if (worker.rasterized.insert(index).second) {
+            output.bitmaps.emplace_back(index, font.RasterizeGlyph(index));
+          }
+        }
+      }
+    }
+  }
+
+  output.isValid = true;
+  output.familyName = font.GetFamilyName();
+  output.subFamilyName = font.GetSubFamilyName();
+  output.axisInfos = font.GetAxisInfos();
+  output.ascend = font.Ascend();
+  output.descend = font.Descend();
+  output.lineHeight = font.LineHeight();
+  output.generation = font.Generation();
+  output.paragraphs = worker.layout.Paragraphs();
+  output.elapsed = std::chrono::steady_clock::now() - start;
+
+  return output;
+}
+
+void UploadJobBitmaps(SDL_Renderer *renderer, GlyphAtlas &atlas,
+                      const uint64_t &face, LayoutJobOutput &output) {
+  for (const auto &[index, bitmap] : output.bitmaps) {
+    // Glyphs rasterized again after an eviction may still be in the atlas.
+    const AtlasKey key{face, output.generation, index};
+    if (!atlas.Contains(key)) {
+      atlas.Insert(renderer, key, bitmap);
+    }
+  }
+  output.bitmaps.clear();
+}
+
+void DrawAtlasLine(SDL_Renderer *renderer, DebugOverlay &overlay,
+                   GlyphAtlas &atlas, const uint64_t &face,
+                   const uint64_t &generation, const LayoutLine &line,
+                   const SDL_Color &color, float x, const float &y) {
+  for (const auto &run : line.runs) {
+    for (size_t i = run.glyphStart; i < run.glyphEnd; i++) {
+      const auto &glyph = run.shaped->glyphs[i];
+
+      auto g = atlas.Find({face, generation, glyph.index});
+      if (g != nullptr && g->texture != nullptr) {
+        DrawGlyph(renderer, overlay, *g, color, x, y, glyph);
+      }
+
+      x += HBPosToFloat(glyph.xAdvance);
+    }
+  }
+}
@@ -0,0 +1,91 @@
+#ifndef LAYOUT_JOB_HPP
+#define LAYOUT_JOB_HPP
+
+#include "debug_overlay.hpp"
+#include "font.hpp"
+#include "glyph_atlas.hpp"
+#include "text_layout.hpp"
+#include <SDL3/SDL.h>
+#include <chrono>
+#include <magic_enum/magic_enum_containers.hpp>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+struct LayoutJobInput {
+  int fontSize{0};
+  RenderMode renderMode{};
+
+  bool isAxisValuesSet{false};
+  magic_enum::containers::array<VariationAxis, float> axisValues{};
+
+  std::u16string text;
+  LayoutOptions options;
+  hb_position_t extent{TextLayout::NO_WRAP};
+
+  bool operator==(const LayoutJobInput &) const = default;
+};
+
+struct LayoutJobOutput {
+  bool isValid{false};
+
+  std::string familyName;
+  std::string subFamilyName;
+  magic_enum::containers::array<VariationAxis, std::optional<AxisInfo>>
+      axisInfos{};
+
+  float ascend{0};
+  float descend{0};
+  float lineHeight{0};
+
+  uint64_t generation{0};
+  std::vector<LayoutParagraph> paragraphs;
+
+  // Glyphs not rasterized by earlier jobs of the same worker.
+  std::vector<std::pair<uint32_t, GlyphBitmap>> bitmaps;
+
+  std::chrono::duration<double> elapsed{};
+};
+
+/*
+ * The state kept between the jobs of one view element (a comparison cell, a
+ * waterfall row...). Only one job per worker runs at a time, so the font is
+ * never used by two threads at once.
+ */
+struct LayoutWorker {
+  std::unique_ptr<Font> font;
+
+  bool isAxisValuesSet{false};
+  magic_enum::containers::array<VariationAxis, float> axisValues{};
+
+  TextLayout layout;
+
+  std::unordered_set<uint32_t> rasterized;
+  uint64_t rasterizedGeneration{0};
+};
+
+/*
+ * Lays out the text with the worker font and rasterizes the glyphs the worker
+ * has not produced yet. `isAtlasStale` makes it rasterize every glyph again,
+ * after the atlas holding the earlier ones was cleared or evicted.
+ */
+LayoutJobOutput RunLayoutJob(LayoutWorker &worker, const LayoutJobInput &input,
+                             const bool &isAtlasStale);
+
+// Uploads the bitmaps of a finished job, keyed by `face` and its generation.
+// Glyphs the atlas already holds are skipped.
+void UploadJobBitmaps(SDL_Renderer *renderer, GlyphAtlas &atlas,
+                      const uint64_t &face, LayoutJobOutput &output);
+
+/*
+ * Draws a line of a job result from the atlas, with the baseline at `y`.
+ * Glyphs not uploaded yet are skipped.
+ */
+void DrawAtlasLine(SDL_Renderer *renderer, DebugOverlay &overlay,
+                   GlyphAtlas &atlas, const uint64_t &face,
+                   const uint64_t &generation, const LayoutLine &line,
+                   const SDL_Color &color, float x, const float &y);
+
+#endif
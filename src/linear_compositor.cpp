@@ -0,0 +1,244 @@
+#include "linear_compositor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Linear values are looked up in sRGB with their 12 most significant bits.
+constexpr int SRGB_LUT_BITS = 12;
+
+struct GammaLut {
+  std::array<uint16_t, 256> toLinear;
+  std::array<uint8_t, 1 << SRGB_LUT_BITS> toSrgb;
+
+  GammaLut() {
+    for (int i = 0; i < 256; i++) {
+      const float v = i / 255.0f;
+      const float linear =
+          v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+      toLinear[i] = static_cast<uint16_t>(std::lround(linear * 65535.0f));
+    }
+
+    for (size_t i = 0; i < toSrgb.size(); i++) {
+      const float v = (i + 0.5f) / toSrgb.size();
+      const float srgb = v <= 0.0031308f
+                             ? v * 12.92f
+                             : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+      toSrgb[i] = static_cast<uint8_t>(std::lround(srgb * 255.0f));
+    }
+  }
+};
+
+const GammaLut &Lut() {
+  static const GammaLut lut;
+  return lut;
+}
+
+/*
+ * dst = dst - dst * a + src * a for `count` pixels, `a` being the coverage
+ * scaled to 16 bits. The products keep their upper half, so no coverage leaves
+ * the pixel as it was and full coverage gives the color within one unit.
+ */
+void BlendRow(uint16_t *dst, const uint8_t *coverage,
+              const std::array<uint16_t, 4> &src, const int &count) {
+  int x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+  __m128i source;
+  std::memcpy(&source, src.data(), 8);
+  source = _mm_unpacklo_epi64(source, source);
+
+  // Two pixels of four channels per step.
+  for (; x + 2 <= count; x += 2) {
+    uint16_t pair;
+    std::memcpy(&pair, coverage + x, sizeof(pair));
+    if (pair == 0)
+      continue;
+
+    // Repeating the byte multiplies it by 257, so 255 maps to 65535.
+    __m128i alpha = _mm_cvtsi32_si128(pair);
+    alpha = _mm_unpacklo_epi8(alpha, alpha);
+    alpha = _mm_unpacklo_epi16(alpha, alpha);
+    alpha = _mm_unpacklo_epi32(alpha, alpha);
+
+    auto *target = reinterpret_cast<__m128i *>(dst + x * 4);
+    const __m128i value = _mm_loadu_si128(target);
+    const __m128i removed = _mm_mulhi_epu16(value, alpha);
+    const __m128i added = _mm_mulhi_epu16(source, alpha);
+    _mm_storeu_si128(target,
+                     _mm_add_epi16(_mm_sub_epi16(value, removed), added));
+  }
+#endif
+
+  for (; x < count; x++) {
+    const uint32_t alpha = coverage[x] * 257u;
+    if (alpha == 0)
+      continue;
+
+    for (int c = 0; c < 4; c++) {
+      auto &value = dst[x * 4 + c];
+      value = static_cast<uint16_t>(value - (value * alpha >> 16) +
+                                    (src[c] * alpha >> 16));
+    }
+  }
+}
+} // namespace
+
+bool LinearCompositor::isEnabled{false};
+
+void LinearCompositor::SetEnabled(const bool &enabled) { isEnabled = enabled; }
+
+LinearCompositor::LinearCompositor(SDL_Renderer *renderer)
+    : renderer(renderer) {
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  viewportWidth = bound.w;
+  viewportHeight = bound.h;
+}
+
+LinearCompositor::~LinearCompositor() { Flush(); }
+
+bool LinearCompositor::ReadBack() {
+  auto *surface = SDL_RenderReadPixels(renderer, nullptr);
+  if (surface == nullptr)
+    return false;
+
+  auto *converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+  SDL_DestroySurface(surface);
+  if (converted == nullptr)
+    return false;
+
+  width = converted->w;
+  height = converted->h;
+  pixels.resize(static_cast<size_t>(width) * height * 4);
+
+  const auto &lut = Lut();
+  for (int y = 0; y < height; y++) {
+    const auto *line =
+        static_cast<const uint8_t *>(converted->pixels) + y * converted->pitch;
+    auto *target = pixels.data() + static_cast<size_t>(y) * width * 4;
+
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) {
+        target[x * 4 + c] = lut.toLinear[line[x * 4 + c]];
+      }
+      target[x * 4 + 3] = 0;
+    }
+  }
+
+  SDL_DestroySurface(converted);
+  return true;
+}
+
+void LinearCompositor::Blend(const GlyphBitmap &bitmap, const SDL_Color &color,
+                             const int &x, const int &y) {
+  if (bitmap.width == 0 || bitmap.height == 0)
+    return;
+
+  if (pixels.empty() && !ReadBack())
+    return;
+
+  const int left = x + bitmap.bound.x;
+  const int top = viewportHeight - (y + bitmap.bound.y + bitmap.bound.h);
+
+  const int columnStart = std::max(0, -left);
+  const int columnEnd = std::min(bitmap.width, width - left);
+  const int rowStart = std::max(0, -top);
+  const int rowEnd = std::min(bitmap.height, height - top);
+  if (columnStart >= columnEnd || rowStart >= rowEnd)
+    return;
+
+  const auto &lut = Lut();
+  const std::array<uint16_t, 4> source{lut.toLinear[color.r],
+                                       lut.toLinear[color.g],
+                                       lut.toLinear[color.b], 0};
+
+  for (int row = rowStart; row < rowEnd; row++) {
+    const auto *coverage =
+        bitmap.pixels.data() + row * bitmap.width + columnStart;
+    auto *target =
+        pixels.data() +
+        (static_cast<size_t>(top + row) * width + left + columnStart) * 4;
+
+    BlendRow(target, coverage, source, columnEnd - columnStart);
+  }
+
+  isDirty = true;
+}
+
+void LinearCompositor::Flush() {
+  if (!isDirty)
+    return;
+
+  isDirty = false;
+
+  auto *surface = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+  if (surface == nullptr)
+    return;
+
+  const auto &lut = Lut();
+  for (int y = 0; y < height; y++) {
+    auto *line = static_cast<uint8_t *>(surface->pixels) + y * surface->pitch;
+    const auto *source = pixels.data() + static_cast<size_t>(y) * width * 4;
+
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) {
+        line[x * 4 + c] =
+            lut.toSrgb[source[x * 4 + c] >> (16 - SRGB_LUT_BITS)];
+      }
+      line[x * 4 + 3] = 255;
+    }
+  }
+
+  auto *texture = SDL_CreateTextureFromSurface(renderer, surface);
+  SDL_DestroySurface(surface);
+  if (texture == nullptr)
+    return;
+
+  const SDL_FRect rect{0, 0, static_cast<float>(viewportWidth),
+                       static_cast<float>(viewportHeight)};
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+  SDL_RenderTexture(renderer, texture, nullptr, &rect);
+  SDL_DestroyTexture(texture);
+}
+
+CompositorBenchmark RunCompositorBenchmark(SDL_Renderer *renderer,
+                                           const std::function<void()> &draw,
+                                           const int &iterations) {
+  const bool wasEnabled = LinearCompositor::IsEnabled();
+
+  // Reading a pixel back waits for the commands before it.
+  const auto run = [&](const bool &isLinear) {
+    LinearCompositor::SetEnabled(isLinear);
+
+    // Rasterizes the glyphs the path has not used yet.
+    draw();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      draw();
+
+      const SDL_Rect pixel{0, 0, 1, 1};
+      SDL_DestroySurface(SDL_RenderReadPixels(renderer, &pixel));
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations;
+  };
+
+  CompositorBenchmark result{.iterations = iterations};
+  result.sdlMs = run(false);
+  result.linearMs = run(true);
+
+  LinearCompositor::SetEnabled(wasEnabled);
+  return result;
+}
@@ -0,0 +1,69 @@
+#ifndef LINEAR_COMPOSITOR_HPP
+#define LINEAR_COMPOSITOR_HPP
+
+#include "font.hpp"
+#include <SDL3/SDL.h>
+#include <functional>
+#include <vector>
+
+/*
+ * Blends glyph coverage on the CPU in linear light instead of letting SDL
+ * blend the sRGB values, which makes light text on a dark background look too
+ * thin and dark text on a light one too bold.
+ *
+ * The first blended glyph reads the viewport back and converts it to 16 bits
+ * per channel of linear light. The glyphs are blended into it, and `Flush()`
+ * converts it back to sRGB and draws it over the viewport in one upload. Like
+ * the Draw functions, the coordinates have their origin in the bottom-left
+ * corner of the viewport.
+ */
+class LinearCompositor {
+public:
+  // Whether the text renderers blend through a compositor.
+  static void SetEnabled(const bool &isEnabled);
+  static bool IsEnabled() { return isEnabled; }
+
+  explicit LinearCompositor(SDL_Renderer *renderer);
+  LinearCompositor(const LinearCompositor &) = delete;
+  LinearCompositor &operator=(const LinearCompositor &) = delete;
+
+  // Draws what was not flushed yet.
+  ~LinearCompositor();
+
+  void Blend(const GlyphBitmap &bitmap, const SDL_Color &color, const int &x,
+             const int &y);
+
+  void Flush();
+
+private:
+  static bool isEnabled;
+
+  bool ReadBack();
+
+  SDL_Renderer *renderer;
+  int viewportWidth{0};
+  int viewportHeight{0};
+
+  // Red, green, blue and an unused channel per pixel.
+  std::vector<uint16_t> pixels;
+  int width{0};
+  int height{0};
+  bool isDirty{false};
+};
+
+struct CompositorBenchmark {
+  int iterations{0};
+  double sdlMs{0};
+  double linearMs{0};
+};
+
+/*
+ * Times `draw` with the SDL blending and with the linear compositor, waiting
+ * for the renderer to finish each iteration. Each path is drawn once before
+ * being timed, so the glyph caches are warm.
+ */
+CompositorBenchmark RunCompositorBenchmark(SDL_Renderer *renderer,
+                                           const std::function<void()> &draw,
+                                           const int &iterations);
+
+#endif
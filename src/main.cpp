@@ -1,8 +1,14 @@
 #define SDL_MAIN_USE_CALLBACKS
 
+#include "corpus_throughput.hpp"
+#include "frame_arena.hpp"
+#include "frame_pacer.hpp"
 #include "io_util.hpp"
 #include "main_scene.hpp"
-#include <IconsForkAwesome.h>
+#include "metrics_export.hpp"
+#include "regression.hpp"
+#include "thread_pool.hpp"
+#include "ui_font.hpp"
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 #include <imgui.h>
@@ -10,6 +16,7 @@
 #include <imgui_impl_sdlrenderer3.h>
 #include <memory>
 #include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/stdout_sinks.h>
 #include <spdlog/spdlog.h>
 
 static constexpr char IMGUI_INI[] = "imgui.ini";
@@ -24,9 +31,40 @@ static constexpr size_t MAX_LOG_FILE = 3;
 namespace {
 SDL_Renderer *renderer = nullptr;
 SDL_Window *window = nullptr;
+
+Uint64 startTime = 0;
+bool isFirstFrame = true;
+
+// Set when started with --regression, --metrics or --corpus, which run
+// without the UI.
+bool isHeadlessRun = false;
 } // namespace
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
+  startTime = SDL_GetTicksNS();
+
+  if (const auto options = ParseRegressionOptions(argc, argv)) {
+    isHeadlessRun = true;
+    spdlog::set_default_logger(spdlog::stdout_logger_mt("regression"));
+
+    return RunRegression(*options) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+  }
+
+  if (const auto options = ParseMetricsOptions(argc, argv)) {
+    isHeadlessRun = true;
+    // The records go to the standard output.
+    spdlog::set_default_logger(spdlog::stderr_logger_mt("metrics"));
+
+    return RunMetricsExport(*options) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+  }
+
+  if (const auto options = ParseCorpusOptions(argc, argv)) {
+    isHeadlessRun = true;
+    spdlog::set_default_logger(spdlog::stdout_logger_mt("corpus"));
+
+    return RunCorpusThroughput(*options) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+  }
+
   const auto logFilePath = GetPreferencePath() / LOGFILE;
   const auto logger = spdlog::rotating_logger_mt(
       "logger", logFilePath.string(), MAX_LOG_FILE_SIZE, MAX_LOG_FILE);
@@ -52,30 +90,20 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
   ImGuiIO &io = ImGui::GetIO();
   io.IniFilename = imguiIniStr.c_str();
 
-  io.Fonts->AddFontFromFileTTF("fonts/NotoSans-Regular.ttf", 20.0f);
-
-  ImFontConfig config;
-  config.MergeMode = true;
+  // A blinking cursor would keep the loop from ever going idle.
+  io.ConfigInputTextCursorBlink = false;
 
-  ImWchar iconRangesFK[] = {ICON_MIN_FK, ICON_MAX_FK, 0};
-  io.Fonts->AddFontFromFileTTF("fonts/forkawesome-webfont.ttf", 20.0f, &config,
-                               iconRangesFK);
-  io.Fonts->AddFontFromFileTTF("fonts/NotoSansJP-Regular.ttf", 20.0f, &config,
-                               io.Fonts->GetGlyphRangesJapanese());
-  io.Fonts->AddFontFromFileTTF("fonts/NotoSansThai-Regular.ttf", 20.0f, &config,
-                               io.Fonts->GetGlyphRangesThai());
-  io.Fonts->AddFontFromFileTTF("fonts/NotoSansKR-Regular.ttf", 20.0f, &config,
-                               io.Fonts->GetGlyphRangesKorean());
-  io.Fonts->AddFontFromFileTTF(
-      "fonts/NotoSansSC-Regular.ttf", 20.0f, &config,
-      io.Fonts->GetGlyphRangesChineseSimplifiedCommon());
-
-  io.Fonts->AddFontFromFileTTF("fonts/NotoSansTC-Regular.ttf", 20.0f, &config,
-                               io.Fonts->GetGlyphRangesChineseFull());
+  UiFontInit();
 
   ImGui_ImplSDL3_InitForSDLRenderer(window, renderer);
   ImGui_ImplSDLRenderer3_Init(renderer);
 
+  if (!FramePacer::Shared().Init()) {
+    return SDL_APP_FAILURE;
+  }
+  ThreadPool::Shared().SetJobDoneCallback(
+      []() { FramePacer::Shared().Wake(); });
+
   if (!SceneInit()) {
     SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error",
                              "Unable to initialize the new scene", window);
@@ -87,6 +115,8 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
 }
 
 SDL_AppResult SDL_AppIterate(void *appstate) {
+  FramePacer::Shared().BeginFrame();
+
   ImGui_ImplSDL3_NewFrame();
   ImGui_ImplSDLRenderer3_NewFrame();
 
@@ -102,11 +132,32 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
   ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), renderer);
   SDL_RenderPresent(renderer);
 
+  FramePacer::Shared().EndFrame();
+
+  if (UiFontUpdate()) {
+    // Created again by the next NewFrame, which shows the new characters.
+    ImGui_ImplSDLRenderer3_DestroyFontsTexture();
+    FramePacer::Shared().Wake();
+  }
+
+  if (isFirstFrame) {
+    const auto elapsed = SDL_GetTicksNS() - startTime;
+    spdlog::info("First frame after {:.1f} ms ({} start).",
+                 static_cast<double>(elapsed) / SDL_NS_PER_MS,
+                 UiFontIsWarm() ? "warm" : "cold");
+    isFirstFrame = false;
+  }
+
+  FrameArena::Shared().Reset();
+
   return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
   ImGui_ImplSDL3_ProcessEvent(event);
+  FramePacer::Shared().OnEvent(*event);
+  SceneHandleEvent(*event);
+
   if (event->type == SDL_EVENT_QUIT) {
     return SDL_APP_SUCCESS;
   }
@@ -114,7 +165,12 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 }
 
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
+  if (isHeadlessRun)
+    return;
+
+  ThreadPool::Shared().SetJobDoneCallback(nullptr);
   SceneCleanUp();
+  UiFontCleanUp();
 
   ImGui_ImplSDLRenderer3_Shutdown();
   ImGui_ImplSDL3_Shutdown();
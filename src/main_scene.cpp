@@ -1,12 +1,32 @@
 #include "main_scene.hpp"
 
+#include "cluster_index.hpp"
 #include "colors.hpp"
+#include "comparison_view.hpp"
+#include "coverage_view.hpp"
+#include "debug_overlay.hpp"
 #include "debug_settings.hpp"
+#include "directory_watcher.hpp"
 #include "font.hpp"
+#include "font_index.hpp"
+#include "frame_arena.hpp"
+#include "frame_pacer.hpp"
+#include "glyph_disk_cache.hpp"
+#include "glyph_grid_view.hpp"
+#include "glyph_table.hpp"
+#include "hash.hpp"
 #include "io_util.hpp"
+#include "linear_compositor.hpp"
+#include "metrics_export.hpp"
+#include "render_cache.hpp"
+#include "render_mode_view.hpp"
 #include "settings.hpp"
+#include "shape_disk_cache.hpp"
+#include "text_layout.hpp"
 #include "text_renderer.hpp"
+#include "ui_font.hpp"
 #include "version.hpp"
+#include "waterfall_view.hpp"
 #include <IconsForkAwesome.h>
 #include <algorithm>
 #include <array>
@@ -16,14 +36,24 @@
 #include <imgui_internal.h>
 #include <magic_enum/magic_enum_all.hpp>
 #include <magic_enum/magic_enum_containers.hpp>
+#include <map>
+#include <memory_resource>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
+#include <sstream>
+#include <unicode/utf16.h>
+#include <unicode/uvernum.h>
 #include <utf8/cpp20.h>
 
 namespace {
 constexpr int TOOLBAR_WIDTH = 400;
 constexpr int PADDING = 30;
 
+constexpr char GLYPH_CACHE_FILE[] = "glyph_cache.bin";
+constexpr char SHAPE_CACHE_FILE[] = "shape_cache.bin";
+constexpr size_t MEBIBYTE = 1024 * 1024;
+
 constexpr std::string_view EXAMPLE_TEXT{
     "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Sed non \n"
     "turpis justo. Etiam luctus vulputate ante ac congue. Nunc vitae \n"
@@ -38,14 +68,35 @@ std::array<char, 4096> buffer = {0};
 SDL_Color foregroundColor = defaultForegroundColor;
 SDL_Color backgroundColor = defaultBackgroundColor;
 
+// Outlines stay sharp at any size, bitmaps are limited to keep the glyph
+// textures reasonable.
+constexpr int MAX_BITMAP_FONT_SIZE = 512;
+constexpr int MAX_VECTOR_FONT_SIZE = 1024;
+
 int fontSize = 64;
+bool isVectorMode = false;
+bool isDraggingFontSize = false;
+RenderMode renderMode{};
 bool isShaping = false;
+bool isWrapping = true;
 
 int selectedFontIndex = -1;
 std::vector<std::filesystem::path> fontFilePaths;
 std::string fontDirPath{std::filesystem::absolute("fonts").string()};
 
+DirectoryWatcher fontDirWatcher;
+Uint32 fontDirChangedEventType = 0;
+
 Font font{};
+TextLayout layout{};
+
+GlyphDiskCache glyphCache;
+bool isGlyphCacheEnabled = true;
+int glyphCacheMaxSize = 256;
+
+ShapeDiskCache shapeCache;
+bool isShapeCacheEnabled = true;
+int shapeCacheMaxSize = 64;
 
 struct ScriptPair {
   const char *name;
@@ -53,15 +104,14 @@ struct ScriptPair {
 };
 
 const std::vector<ScriptPair> scripts{
+    ScriptPair{"Auto", HB_SCRIPT_INVALID},
     ScriptPair{"Common", HB_SCRIPT_COMMON},
     ScriptPair{"Thai", HB_SCRIPT_THAI},
     ScriptPair{"Hiragana", HB_SCRIPT_HIRAGANA},
     ScriptPair{"Katakana", HB_SCRIPT_KATAKANA},
     ScriptPair{"Han", HB_SCRIPT_HAN},
     ScriptPair{"Hangul", HB_SCRIPT_HANGUL},
-#ifdef ENABLE_RTL
     ScriptPair{"Arabic", HB_SCRIPT_ARABIC},
-#endif
 };
 
 struct LanguagePair {
@@ -98,22 +148,88 @@ const std::vector<LanguagePair> languages{
         "Chinese Taiwan",
         "zh-TW",
     },
-#ifdef ENABLE_RTL
     LanguagePair{
         "Arabic Saudi Arabia",
         "ar-SA",
     },
-#endif
 };
 
 DebugSettings debug{};
 
+enum class ViewMode {
+  Text,
+  Comparison,
+  Waterfall,
+  RenderModes,
+  GlyphGrid,
+};
+
+ViewMode viewMode{ViewMode::Text};
+
 bool isShowingTextEditor = true;
+bool isShowingCoverage = false;
+bool isShowingDuplicates = false;
 int selectedScript = 0;
 int selectedLanguage = 0;
 
 TextDirection selectedDirection{TextDirection::LeftToRight};
 
+// OpenType features turned on or off by the user. The range is in UTF-16
+// offsets of each paragraph.
+struct FeatureOverride {
+  bool isEnabled{true};
+  bool isRanged{false};
+  int start{0};
+  int end{1};
+};
+
+std::map<hb_tag_t, FeatureOverride> featureOverrides;
+
+std::optional<GlyphLookupBenchmark> glyphLookupBenchmark;
+
+// Run by the next tick of the text view, which has the renderer set up.
+constexpr int COMPOSITOR_BENCHMARK_ITERATIONS = 20;
+bool isCompositorBenchmarkPending = false;
+std::optional<CompositorBenchmark> compositorBenchmark;
+
+// Set by the save dialog, which may call back from another thread.
+std::mutex metricsExportMutex;
+std::optional<std::filesystem::path> metricsExportPath;
+
+// Filled again every frame, reusing the memory of the previous one.
+LayoutOptions layoutOptions{};
+
+// Everything the text view depends on. The font generation covers the font
+// file, its size and its variation. The text and the features are hashed, so
+// building the key every frame does not allocate.
+struct TextViewKey {
+  uint64_t fontGeneration{0};
+  uint64_t text{0};
+  bool isVectorMode{false};
+  bool isLinearBlending{false};
+  bool isShaping{false};
+  bool isWrapping{false};
+  int script{0};
+  int language{0};
+  TextDirection direction{TextDirection::LeftToRight};
+  uint64_t features{0};
+  uint32_t foregroundColor{0};
+  uint32_t backgroundColor{0};
+  DebugSettings debug{};
+  int width{0};
+  int height{0};
+
+  bool operator==(const TextViewKey &) const = default;
+};
+
+TextViewKey textViewKey;
+RenderCache textViewCache;
+
+// Where the clusters of the text view are, rebuilt whenever it is drawn.
+ClusterIndex clusterIndex;
+std::optional<ClusterHit> hoveredCluster;
+SDL_Rect textViewport{};
+
 magic_enum::containers::array<VariationAxis, float> axisValue;
 magic_enum::containers::array<VariationAxis, std::optional<AxisInfo>>
     axisLimits;
@@ -144,6 +260,37 @@ ListFontFiles(const std::filesystem::path &path) {
   return output;
 }
 
+// Lays the text out like the single font view does, wrapped to the viewport.
+void ExportPendingMetrics(std::string_view utf8Text,
+                          const LayoutOptions &options,
+                          const SDL_Rect &viewport) {
+  std::optional<std::filesystem::path> path;
+  {
+    std::scoped_lock lock(metricsExportMutex);
+    path.swap(metricsExportPath);
+  }
+  if (!path.has_value() || !font.IsValid())
+    return;
+
+  hb_position_t extent = TextLayout::NO_WRAP;
+  if (isWrapping) {
+    extent = FloatToHBPos(selectedDirection == TextDirection::TopToBottom
+                              ? viewport.h
+                              : viewport.w);
+  }
+
+  std::istringstream input{std::string(utf8Text)};
+  std::ofstream output(*path, std::ios::out | std::ios::binary);
+  if (!output) {
+    spdlog::error("Unable to write {}", path->string());
+    return;
+  }
+
+  const auto stats = ExportMetrics(font, options, extent, input, output);
+  spdlog::info("Exported {} lines of metrics to {}", stats.lines,
+               path->string());
+}
+
 void OnDirectorySelected(const std::filesystem::path &path) {
   std::filesystem::path newPath = path;
 
@@ -151,55 +298,275 @@ void OnDirectorySelected(const std::filesystem::path &path) {
     newPath = std::filesystem::absolute("fonts");
   }
   fontDirPath = path.string();
+
+  // Files may have been added or removed, so the selection is kept by path.
+  const auto selectedPath = selectedFontIndex == -1
+                                ? std::filesystem::path{}
+                                : fontFilePaths[selectedFontIndex];
+
   fontFilePaths = ListFontFiles(fontDirPath);
+  FontIndex::Shared().Scan(fontFilePaths);
+  fontDirWatcher.Start(fontDirPath, fontDirChangedEventType);
+
+  const auto selected = std::ranges::find(fontFilePaths, selectedPath);
+  if (selected != fontFilePaths.end()) {
+    selectedFontIndex =
+        static_cast<int>(std::distance(fontFilePaths.begin(), selected));
+  } else if (selectedFontIndex != -1) {
+    font = Font();
+    selectedFontIndex = -1;
+  }
+
+  UiFontRequest(fontDirPath);
+  for (const auto &fontFilePath : fontFilePaths) {
+    UiFontRequest(fontFilePath.filename().string());
+  }
 }
 
-void RenderText(SDL_Renderer *renderer, bool isShaping, const char *language,
-                hb_script_t script, TextDirection direction,
-                DebugSettings &debug) {
-  if (!font.IsValid())
+// Whether `path` has the same content as the font already loaded.
+bool IsFontLoaded(const std::filesystem::path &path) {
+  return font.IsValid() && FontIndex::Shared().Hash(path) == font.ContentHash();
+}
+
+void OpenGlyphCache() {
+  if (!isGlyphCacheEnabled) {
+    glyphCache.Close();
     return;
+  }
 
-  std::string str(buffer.data());
+  glyphCache.Open(GetPreferencePath() / GLYPH_CACHE_FILE,
+                  static_cast<size_t>(glyphCacheMaxSize) * MEBIBYTE);
+}
+
+void OpenShapeCache() {
+  if (!isShapeCacheEnabled) {
+    shapeCache.Close();
+    return;
+  }
+
+  shapeCache.Open(GetPreferencePath() / SHAPE_CACHE_FILE,
+                  static_cast<size_t>(shapeCacheMaxSize) * MEBIBYTE);
+}
+
+// The overrides of the features the current font has, the others are left to
+// the shaper.
+void OverriddenFeatures(FeatureSettings &output) {
+  output.clear();
+
+  for (const auto &tag : font.FeatureTags()) {
+    auto iter = featureOverrides.find(tag);
+    if (iter == featureOverrides.end())
+      continue;
+
+    const auto &feature = iter->second;
+    FeatureSetting setting{
+        .tag = tag,
+        .value = feature.isEnabled ? 1u : 0u,
+    };
+
+    if (feature.isRanged) {
+      setting.start = static_cast<uint32_t>(feature.start);
+      setting.end = static_cast<uint32_t>(feature.end);
+    }
+
+    output.push_back(setting);
+  }
+}
+
+void DoFeaturesUI() {
+  const auto &tags = font.FeatureTags();
+  if (tags.empty()) {
+    ImGui::TextDisabled("The font has no OpenType features.");
+    return;
+  }
+
+  if (ImGui::Button("Reset##features")) {
+    featureOverrides.clear();
+  }
+
+  for (const auto &tag : tags) {
+    char name[5]{};
+    hb_tag_to_string(tag, name);
+
+    ImGui::PushID(static_cast<int>(tag));
+
+    auto iter = featureOverrides.find(tag);
+    int state = 0;
+    if (iter != featureOverrides.end()) {
+      state = iter->second.isEnabled ? 1 : 2;
+    }
+
+    ImGui::Text("%s", name);
+    ImGui::SameLine(60);
+    bool isChanged = ImGui::RadioButton("Default", &state, 0);
+    ImGui::SameLine();
+    isChanged |= ImGui::RadioButton("On", &state, 1);
+    ImGui::SameLine();
+    isChanged |= ImGui::RadioButton("Off", &state, 2);
+
+    if (isChanged) {
+      if (state == 0) {
+        featureOverrides.erase(tag);
+      } else {
+        featureOverrides[tag].isEnabled = state == 1;
+      }
+    }
+
+    if (state != 0) {
+      auto &feature = featureOverrides[tag];
+
+      ImGui::Indent();
+      ImGui::Checkbox("Range", &feature.isRanged);
+      if (feature.isRanged) {
+        ImGui::SameLine();
+        ImGui::DragIntRange2("##range", &feature.start, &feature.end, 0.1f, 0,
+                             static_cast<int>(buffer.size()));
+      }
+      ImGui::Unindent();
+    }
+
+    ImGui::PopID();
+  }
+}
+
+hb_direction_t ToHbDirection(const TextDirection &direction) {
+  switch (direction) {
+  case TextDirection::TopToBottom:
+    return HB_DIRECTION_TTB;
+
+  case TextDirection::RightToLeft:
+    return HB_DIRECTION_RTL;
+
+  default:
+    return HB_DIRECTION_LTR;
+  }
+}
+
+void RenderText(SDL_Renderer *renderer, bool isShaping,
+                std::u16string_view text, const LayoutOptions &options,
+                TextDirection direction, DebugSettings &debug) {
+  clusterIndex.Clear(false);
+
+  if (!font.IsValid())
+    return;
 
   SDL_Color sdlColor = foregroundColor;
 
   if (!isShaping) {
-    TextRenderNoShape(renderer, debug, font, str, sdlColor);
+    TextRenderNoShape(renderer, debug, font, text, sdlColor);
     return;
   }
 
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  hb_position_t extent = TextLayout::NO_WRAP;
+  if (isWrapping) {
+    extent = FloatToHBPos(direction == TextDirection::TopToBottom ? bound.h
+                                                                  : bound.w);
+  }
+
+  layout.Update(font, text, options, extent, FrameArena::Shared().Resource());
+
   switch (direction) {
   case TextDirection::LeftToRight:
-    TextRenderLeftToRight(renderer, debug, font, str, sdlColor, language,
-                          script);
+    TextRenderLeftToRight(renderer, debug, font, layout, sdlColor,
+                          clusterIndex);
     return;
 
   case TextDirection::TopToBottom:
-    TextRenderTopToBottom(renderer, debug, font, str, sdlColor, language,
-                          script);
+    TextRenderTopToBottom(renderer, debug, font, layout, sdlColor,
+                          clusterIndex);
     return;
 
-#ifdef ENABLE_RTL
   case TextDirection::RightToLeft:
-    TextRenderRightToLeft(renderer, debug, font, str, sdlColor, language,
-                          script);
+    TextRenderRightToLeft(renderer, debug, font, layout, sdlColor,
+                          clusterIndex);
     return;
-#endif
   }
 };
+
+std::optional<ClusterHit> FindHoveredCluster() {
+  const auto &io = ImGui::GetIO();
+  if (viewMode != ViewMode::Text || io.WantCaptureMouse)
+    return std::nullopt;
+
+  // To the bottom-left origin of the text view.
+  const float x = io.MousePos.x - textViewport.x;
+  const float y = textViewport.h - (io.MousePos.y - textViewport.y);
+  if (x < 0 || y < 0 || x >= textViewport.w || y >= textViewport.h)
+    return std::nullopt;
+
+  const auto hit = clusterIndex.Find(x, y);
+  if (hit == nullptr)
+    return std::nullopt;
+
+  return *hit;
+}
+
+void ShowClusterTooltip(const ClusterHit &hit) {
+  const auto &paragraphs = layout.Paragraphs();
+  if (hit.paragraph >= paragraphs.size() ||
+      hit.textEnd > paragraphs[hit.paragraph].text.size())
+    return;
+
+  const auto &text = paragraphs[hit.paragraph].text;
+
+  ImGui::BeginTooltip();
+
+  ImGui::Text("Paragraph %zu, UTF-16 offsets %zu to %zu", hit.paragraph,
+              hit.textStart, hit.textEnd);
+
+  ImGui::SeparatorText("Code points");
+  for (size_t i = hit.textStart; i < hit.textEnd;) {
+    UChar32 c;
+    U16_NEXT(text.data(), i, hit.textEnd, c);
+    ImGui::Text("U+%04X", static_cast<unsigned int>(c));
+    ImGui::SameLine();
+  }
+  ImGui::NewLine();
+
+  ImGui::SeparatorText("Glyphs");
+  const auto &glyphs = clusterIndex.Glyphs();
+  for (size_t i = hit.glyphStart; i < hit.glyphEnd && i < glyphs.size(); i++) {
+    const auto &glyph = glyphs[i];
+    ImGui::Text("#%u at (%.1f, %.1f), advance (%.1f, %.1f), "
+                "offset (%.1f, %.1f)",
+                glyph.index, glyph.x, glyph.y, HBPosToFloat(glyph.xAdvance),
+                HBPosToFloat(glyph.yAdvance), HBPosToFloat(glyph.xOffset),
+                HBPosToFloat(glyph.yOffset));
+  }
+
+  ImGui::EndTooltip();
+}
 } // namespace
 
 bool SceneInit() {
   if (!Font::Init())
     return false;
 
-  auto [fontPath] = LoadSettings();
-  fontDirPath = fontPath.string();
+  auto settings = LoadSettings();
+  fontDirPath = settings.fontPath.string();
 
+  isGlyphCacheEnabled = settings.isGlyphCacheEnabled;
+  glyphCacheMaxSize = static_cast<int>(settings.glyphCacheMaxSize / MEBIBYTE);
+
+  isShapeCacheEnabled = settings.isShapeCacheEnabled;
+  shapeCacheMaxSize = static_cast<int>(settings.shapeCacheMaxSize / MEBIBYTE);
+
+  OpenGlyphCache();
+  Font::SetDiskCache(&glyphCache);
+
+  OpenShapeCache();
+  Font::SetShapeDiskCache(&shapeCache);
+
+  FramePacer::Shared().SetMaxFps(settings.maxFps);
+
+  fontDirChangedEventType = SDL_RegisterEvents(1);
   OnDirectorySelected(fontDirPath);
 
   std::copy(std::cbegin(EXAMPLE_TEXT), std::cend(EXAMPLE_TEXT), buffer.begin());
+  UiFontRequest(buffer.data());
 
   return true;
 }
@@ -215,29 +582,162 @@ void SceneTick(SDL_Renderer *renderer) {
   viewport.h -= 2 * PADDING;
 
   SDL_SetRenderViewport(renderer, &viewport);
+  textViewport = viewport;
 
   SDL_SetRenderDrawColor(renderer, backgroundColor.r, backgroundColor.g,
                          backgroundColor.b, backgroundColor.a);
   SDL_RenderClear(renderer);
 
   font.SetFontSize(fontSize);
+  font.SetVectorMode(isVectorMode);
+  font.SetPreviewing(isDraggingFontSize);
+  font.SetRenderMode(renderMode);
+
+  layoutOptions.direction = ToHbDirection(selectedDirection);
+  layoutOptions.script = scripts[selectedScript].script;
+  layoutOptions.language = languages[selectedLanguage].code;
+  OverriddenFeatures(layoutOptions.features);
+
+  const auto &options = layoutOptions;
+
+  // The views copy what they keep of it.
+  const std::string_view utf8Text{buffer.data()};
+  std::pmr::u16string text(FrameArena::Shared().Resource());
+  text.reserve(utf8Text.size());
+  utf8::utf8to16(utf8Text.begin(), utf8Text.end(), std::back_inserter(text));
+
+  ExportPendingMetrics(utf8Text, options, viewport);
+
+  if (viewMode == ViewMode::Comparison) {
+    // Compared on bitmaps.
+    ComparisonTick(renderer, debug, text,
+                   std::min(fontSize, MAX_BITMAP_FONT_SIZE), options,
+                   foregroundColor);
+    return;
+  }
+
+  if (viewMode == ViewMode::GlyphGrid) {
+    GlyphGridTick(renderer, debug, font, axisValue, foregroundColor);
+    return;
+  }
+
+  if (viewMode == ViewMode::Waterfall) {
+    WaterfallTick(renderer, debug, font, axisValue, text, options,
+                  foregroundColor);
+    return;
+  }
+
+  if (viewMode == ViewMode::RenderModes) {
+    RenderModeTick(renderer, debug, font, axisValue, text,
+                   std::min(fontSize, MAX_BITMAP_FONT_SIZE), options,
+                   foregroundColor);
+    return;
+  }
+
+  const TextViewKey key{
+      .fontGeneration = font.Generation(),
+      .text = Hash64(utf8Text.data(), utf8Text.size()),
+      .isVectorMode = font.IsVectorMode(),
+      .isLinearBlending = LinearCompositor::IsEnabled(),
+      .isShaping = isShaping,
+      .isWrapping = isWrapping,
+      .script = selectedScript,
+      .language = selectedLanguage,
+      .direction = selectedDirection,
+      .features = Hash64(options.features.data(),
+                         options.features.size() * sizeof(FeatureSetting)),
+      .foregroundColor = PackColor(foregroundColor),
+      .backgroundColor = PackColor(backgroundColor),
+      .debug = debug,
+      .width = viewport.w,
+      .height = viewport.h,
+  };
+  if (key != textViewKey) {
+    textViewKey = key;
+    textViewCache.Invalidate();
+  }
 
-  auto language = languages[selectedLanguage].code;
-  auto script = scripts[selectedScript].script;
+  if (isCompositorBenchmarkPending) {
+    isCompositorBenchmarkPending = false;
+
+    // Draws over the view, which is redrawn right after.
+    compositorBenchmark = RunCompositorBenchmark(
+        renderer,
+        [&] {
+          SDL_SetRenderDrawColor(renderer, backgroundColor.r,
+                                 backgroundColor.g, backgroundColor.b,
+                                 backgroundColor.a);
+          SDL_RenderClear(renderer);
+          RenderText(renderer, isShaping, text, options, selectedDirection,
+                     debug);
+        },
+        COMPOSITOR_BENCHMARK_ITERATIONS);
+    textViewCache.Invalidate();
+  }
+
+  if (textViewCache.Begin(renderer, viewport.w, viewport.h)) {
+    SDL_SetRenderDrawColor(renderer, backgroundColor.r, backgroundColor.g,
+                           backgroundColor.b, backgroundColor.a);
+    SDL_RenderClear(renderer);
 
-  RenderText(renderer, isShaping, language.data(), script, selectedDirection,
-             debug);
+    RenderText(renderer, isShaping, text, options, selectedDirection, debug);
+
+    textViewCache.End(renderer);
+  }
+  textViewCache.Draw(renderer);
+
+  if (hoveredCluster.has_value()) {
+    const auto &hit = *hoveredCluster;
+    DebugOverlay overlay(renderer, debug);
+    overlay.FillRect(hit.left, hit.bottom, hit.right - hit.left,
+                     hit.top - hit.bottom, clusterHighlightColor);
+  }
 
   SDL_GetRenderViewport(renderer, nullptr);
 }
 
 void SceneCleanUp() {
+  fontDirWatcher.Stop();
+  textViewCache.Release();
+  ComparisonCleanUp();
+  WaterfallCleanUp();
+  RenderModeCleanUp();
+  GlyphGridCleanUp();
+  CoverageCleanUp();
   font = {};
   Font::CleanUp();
-  SaveSettings({.fontPath = fontDirPath});
+  glyphCache.Close();
+  shapeCache.Close();
+  SaveSettings({
+      .fontPath = fontDirPath,
+      .isGlyphCacheEnabled = isGlyphCacheEnabled,
+      .glyphCacheMaxSize = static_cast<size_t>(glyphCacheMaxSize) * MEBIBYTE,
+      .isShapeCacheEnabled = isShapeCacheEnabled,
+      .shapeCacheMaxSize = static_cast<size_t>(shapeCacheMaxSize) * MEBIBYTE,
+      .maxFps = FramePacer::Shared().MaxFps(),
+  });
+}
+
+void SceneHandleEvent(const SDL_Event &event) {
+  if (event.type == SDL_EVENT_RENDER_TARGETS_RESET ||
+      event.type == SDL_EVENT_RENDER_DEVICE_RESET) {
+    textViewCache.Invalidate();
+  }
+
+  if (event.type == fontDirChangedEventType) {
+    spdlog::info("Font directory changed, scanning it again.");
+    OnDirectorySelected(fontDirPath);
+  }
 }
 
 void SceneDoUI(SDL_Window *window) {
+  FontIndex::Shared().Poll();
+
+  hoveredCluster = FindHoveredCluster();
+  if (hoveredCluster.has_value()) {
+    ShowClusterTooltip(*hoveredCluster);
+  }
+
   int newSelected = selectedFontIndex;
   bool showAbout = false;
   if (ImGui::BeginMainMenuBar()) {
@@ -259,7 +759,25 @@ void SceneDoUI(SDL_Window *window) {
       }
 
       if (ImGui::MenuItem("Re-scan font directory##file-menu")) {
-        fontFilePaths = ListFontFiles(fontDirPath);
+        OnDirectorySelected(fontDirPath);
+        newSelected = selectedFontIndex;
+      }
+
+      if (ImGui::MenuItem("Export metrics##file-menu", nullptr, false,
+                          font.IsValid())) {
+        static constexpr SDL_DialogFileFilter filters[] = {
+            {"JSON Lines", "jsonl"},
+        };
+        SDL_ShowSaveFileDialog(
+            [](void *userdata, const char *const *filelist,
+               int filter) -> void {
+              if (filelist == nullptr || filelist[0] == nullptr) {
+                return;
+              }
+              std::scoped_lock lock(metricsExportMutex);
+              metricsExportPath = filelist[0];
+            },
+            nullptr, window, filters, 1, nullptr);
       }
 
       ImGui::Separator();
@@ -279,6 +797,30 @@ void SceneDoUI(SDL_Window *window) {
     if (ImGui::BeginMenu("View##menu")) {
       ImGui::MenuItem("Text editor##view-menu", "", &isShowingTextEditor);
       ImGui::MenuItem("Debug##view-menu", "", &debug.enabled);
+      ImGui::MenuItem("Coverage##view-menu", "", &isShowingCoverage);
+
+      ImGui::Separator();
+
+      if (ImGui::MenuItem("Single font##view-menu", "",
+                          viewMode == ViewMode::Text)) {
+        viewMode = ViewMode::Text;
+      }
+      if (ImGui::MenuItem("Comparison##view-menu", "",
+                          viewMode == ViewMode::Comparison)) {
+        viewMode = ViewMode::Comparison;
+      }
+      if (ImGui::MenuItem("Waterfall##view-menu", "",
+                          viewMode == ViewMode::Waterfall)) {
+        viewMode = ViewMode::Waterfall;
+      }
+      if (ImGui::MenuItem("Render modes##view-menu", "",
+                          viewMode == ViewMode::RenderModes)) {
+        viewMode = ViewMode::RenderModes;
+      }
+      if (ImGui::MenuItem("Glyph grid##view-menu", "",
+                          viewMode == ViewMode::GlyphGrid)) {
+        viewMode = ViewMode::GlyphGrid;
+      }
 
       ImGui::EndMenu();
     }
@@ -306,6 +848,14 @@ void SceneDoUI(SDL_Window *window) {
     if (ImGui::BeginMenuBar()) {
       ImGui::LabelText(ICON_FK_FOLDER " Font Directory", "%s",
                        fontDirPath.c_str());
+
+      const auto &index = FontIndex::Shared();
+      if (index.PendingCount() > 0) {
+        ImGui::Text("Indexing %zu files...", index.PendingCount());
+      } else {
+        ImGui::Text("%zu files, %zu unique", index.FileCount(),
+                    index.UniqueCount());
+      }
       ImGui::EndMenuBar();
     }
   }
@@ -323,28 +873,60 @@ void SceneDoUI(SDL_Window *window) {
               : fontFilePaths[selectedFontIndex].filename().string();
 
       if (ImGui::BeginCombo("Font file", currentFile.c_str())) {
+        const auto &index = FontIndex::Shared();
         for (int i = 0; i < fontFilePaths.size(); i++) {
           auto isSelected = i == selectedFontIndex;
+          auto label = fontFilePaths[i].filename().string();
+
+          if (index.IsDuplicate(fontFilePaths[i])) {
+            if (!isShowingDuplicates && !isSelected)
+              continue;
+
+            label += " (same as " +
+                     index.Canonical(fontFilePaths[i]).filename().string() +
+                     ")";
+          }
+
           if (isSelected) {
             ImGui::SetItemDefaultFocus();
           }
 
-          if (ImGui::Selectable(fontFilePaths[i].filename().string().c_str(),
-                                isSelected)) {
+          ImGui::PushID(i);
+          if (ImGui::Selectable(label.c_str(), isSelected)) {
             newSelected = i;
           }
+          ImGui::PopID();
         }
 
         ImGui::EndCombo();
       }
 
+      ImGui::Checkbox("Show duplicates", &isShowingDuplicates);
+
       ImGui::LabelText("Family name", "%s", font.GetFamilyName().c_str());
       ImGui::LabelText("Sub-family name", "%s",
                        font.GetSubFamilyName().c_str());
     }
 
     if (ImGui::CollapsingHeader("Parameters", ImGuiTreeNodeFlags_DefaultOpen)) {
-      ImGui::SliderInt("Font Size", &fontSize, 0, 128);
+      ImGui::SliderInt("Font Size", &fontSize, 0,
+                       isVectorMode ? MAX_VECTOR_FONT_SIZE
+                                    : MAX_BITMAP_FONT_SIZE);
+      isDraggingFontSize = ImGui::IsItemActive();
+
+      if (ImGui::Checkbox("Vector outlines", &isVectorMode) && !isVectorMode) {
+        fontSize = std::min(fontSize, MAX_BITMAP_FONT_SIZE);
+      }
+
+      auto isLinearBlending = LinearCompositor::IsEnabled();
+      if (ImGui::Checkbox("Linear blending", &isLinearBlending)) {
+        LinearCompositor::SetEnabled(isLinearBlending);
+      }
+
+      ImGui::SeparatorText("Render mode");
+      ImGui::PushID("render mode");
+      RenderModeEdit(renderMode);
+      ImGui::PopID();
 
       ImGui::SeparatorText("Variations");
       ImGui::BeginDisabled(!font.IsVariableFont());
@@ -409,9 +991,7 @@ void SceneDoUI(SDL_Window *window) {
           directionLabels{
               "Left to right",
               "Top to bottom",
-#ifdef ENABLE_RTL
               "Right to left",
-#endif
           };
 
       if (ImGui::BeginCombo("Direction", directionLabels[selectedDirection])) {
@@ -425,9 +1005,125 @@ void SceneDoUI(SDL_Window *window) {
 
         ImGui::EndCombo();
       }
+
+      ImGui::Checkbox("Wrap text", &isWrapping);
+
+      if (ImGui::TreeNode("Features")) {
+        DoFeaturesUI();
+        ImGui::TreePop();
+      }
       ImGui::EndDisabled();
     }
 
+    if (ImGui::CollapsingHeader("Disk caches")) {
+      ImGui::SeparatorText("Glyphs");
+      if (ImGui::Checkbox("Keep glyphs on disk", &isGlyphCacheEnabled)) {
+        OpenGlyphCache();
+      }
+
+      ImGui::BeginDisabled(!isGlyphCacheEnabled);
+      ImGui::SliderInt("Size limit (MiB)##glyph cache", &glyphCacheMaxSize, 16,
+                       4096);
+      if (ImGui::IsItemDeactivatedAfterEdit()) {
+        OpenGlyphCache();
+      }
+
+      ImGui::LabelText("Glyphs", "%zu", glyphCache.RecordCount());
+      ImGui::LabelText("File size", "%.1f MiB",
+                       static_cast<double>(glyphCache.FileSize()) / MEBIBYTE);
+      ImGui::LabelText("Hits / misses", "%zu / %zu", glyphCache.HitCount(),
+                       glyphCache.MissCount());
+
+      if (ImGui::Button("Clear##glyph cache")) {
+        glyphCache.Clear();
+      }
+      ImGui::EndDisabled();
+
+      ImGui::SeparatorText("Shaping results");
+      if (ImGui::Checkbox("Keep shaping results on disk",
+                          &isShapeCacheEnabled)) {
+        OpenShapeCache();
+      }
+
+      ImGui::BeginDisabled(!isShapeCacheEnabled);
+      ImGui::SliderInt("Size limit (MiB)##shape cache", &shapeCacheMaxSize, 16,
+                       1024);
+      if (ImGui::IsItemDeactivatedAfterEdit()) {
+        OpenShapeCache();
+      }
+
+      ImGui::LabelText("Runs", "%zu", shapeCache.RecordCount());
+      ImGui::LabelText("File size##shape cache", "%.1f MiB",
+                       static_cast<double>(shapeCache.FileSize()) / MEBIBYTE);
+      ImGui::LabelText("Hits / misses##shape cache", "%zu / %zu",
+                       shapeCache.HitCount(), shapeCache.MissCount());
+
+      if (ImGui::Button("Clear##shape cache")) {
+        shapeCache.Clear();
+      }
+      ImGui::EndDisabled();
+    }
+
+    if (ImGui::CollapsingHeader("Performance")) {
+      auto &pacer = FramePacer::Shared();
+
+      auto isBenchmarkMode = pacer.IsBenchmarkMode();
+      if (ImGui::Checkbox("Benchmark mode", &isBenchmarkMode)) {
+        pacer.SetBenchmarkMode(isBenchmarkMode);
+      }
+
+      ImGui::BeginDisabled(isBenchmarkMode);
+      auto maxFps = pacer.MaxFps();
+      if (ImGui::SliderInt("Max FPS", &maxFps, 10, 240)) {
+        pacer.SetMaxFps(maxFps);
+      }
+      ImGui::EndDisabled();
+
+      ImGui::LabelText("Frame rate", "%.1f FPS", ImGui::GetIO().Framerate);
+      ImGui::LabelText("Frames rendered", "%zu", pacer.FrameCount());
+      ImGui::LabelText("Text view redraws", "%zu / %zu",
+                       textViewCache.DrawCount(),
+                       textViewCache.DrawCount() + textViewCache.HitCount());
+
+      const auto &arena = FrameArena::Shared();
+      ImGui::LabelText("Frame arena", "%zu allocations, %zu KiB",
+                       arena.AllocationCount(), arena.BytesUsed() / 1024);
+      ImGui::LabelText("Arena heap allocations", "%zu (%zu KiB reserved)",
+                       arena.HeapAllocationCount(), arena.Capacity() / 1024);
+
+      ImGui::LabelText("Cached outlines", "%zu", font.OutlineCount());
+
+      ImGui::SeparatorText("Compositor");
+      ImGui::BeginDisabled(viewMode != ViewMode::Text);
+      if (ImGui::Button("Run benchmark##compositor")) {
+        isCompositorBenchmarkPending = true;
+      }
+      ImGui::EndDisabled();
+
+      if (compositorBenchmark.has_value()) {
+        const auto &result = *compositorBenchmark;
+        ImGui::LabelText("Iterations", "%d", result.iterations);
+        ImGui::LabelText("SDL blending", "%.2f ms", result.sdlMs);
+        ImGui::LabelText("Linear blending", "%.2f ms", result.linearMs);
+      }
+
+      ImGui::SeparatorText("Glyph lookup");
+      if (ImGui::Button("Run benchmark##glyph lookup")) {
+        // The glyph count of the font, or about a CJK font without one.
+        const size_t glyphCount = font.IsValid() ? font.GlyphCount() : 20000;
+        glyphLookupBenchmark = RunGlyphLookupBenchmark(glyphCount, 1'000'000);
+      }
+
+      if (glyphLookupBenchmark.has_value()) {
+        const auto &result = *glyphLookupBenchmark;
+        ImGui::LabelText("Glyphs / lookups", "%zu / %zu", result.glyphCount,
+                         result.lookupCount);
+        ImGui::LabelText("std::map", "%.1f ns", result.mapNs);
+        ImGui::LabelText("Dense table", "%.1f ns", result.denseNs);
+        ImGui::LabelText("Hash table", "%.1f ns", result.hashNs);
+      }
+    }
+
     if (ImGui::CollapsingHeader("Draw colors")) {
       auto f4Foreground = SDLColorToFloat4(foregroundColor);
       if (ImGui::ColorPicker3("Foreground##color", f4Foreground.data(),
@@ -452,11 +1148,34 @@ void SceneDoUI(SDL_Window *window) {
 
   if (isShowingTextEditor) {
     if (ImGui::Begin("Input text", &isShowingTextEditor)) {
-      ImGui::InputTextMultiline("##InputText", buffer.data(), buffer.size());
+      if (ImGui::InputTextMultiline("##InputText", buffer.data(),
+                                    buffer.size())) {
+        UiFontRequest(buffer.data());
+      }
     }
     ImGui::End();
   }
 
+  if (isShowingCoverage) {
+    CoverageDoUI(&isShowingCoverage, font, buffer.data());
+  }
+
+  if (viewMode == ViewMode::Comparison) {
+    ComparisonDoUI(fontFilePaths);
+  }
+
+  if (viewMode == ViewMode::Waterfall) {
+    WaterfallDoUI();
+  }
+
+  if (viewMode == ViewMode::RenderModes) {
+    RenderModeDoUI();
+  }
+
+  if (viewMode == ViewMode::GlyphGrid) {
+    GlyphGridDoUI();
+  }
+
   if (debug.enabled) {
     if (ImGui::Begin("Debug", &debug.enabled)) {
       if (ImGui::CollapsingHeader("Features", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -494,6 +1213,27 @@ void SceneDoUI(SDL_Window *window) {
             "Descend", SDLColorToImVec4(debugDescendColor),
             ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker |
                 ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoLabel);
+
+        ImGui::Checkbox("Cluster Boundaries", &debug.debugClusters);
+        ImGui::SameLine();
+        ImGui::ColorButton(
+            "Cluster Boundaries", SDLColorToImVec4(debugClusterColor),
+            ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker |
+                ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoLabel);
+
+        ImGui::Checkbox("Advance Vectors", &debug.debugAdvance);
+        ImGui::SameLine();
+        ImGui::ColorButton(
+            "Advance Vectors", SDLColorToImVec4(debugAdvanceColor),
+            ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker |
+                ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoLabel);
+
+        ImGui::Checkbox("Advance Bound", &debug.debugAdvanceBox);
+        ImGui::SameLine();
+        ImGui::ColorButton(
+            "Advance Bound", SDLColorToImVec4(debugAdvanceBoxColor),
+            ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker |
+                ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoLabel);
       }
     }
     ImGui::End();
@@ -503,14 +1243,21 @@ void SceneDoUI(SDL_Window *window) {
     if (newSelected == -1) {
       font = Font();
       selectedFontIndex = newSelected;
+    } else if (IsFontLoaded(fontFilePaths[newSelected])) {
+      selectedFontIndex = newSelected;
     } else {
+      auto [data, hash] = FontIndex::Shared().Load(fontFilePaths[newSelected]);
+
       Font newFont;
-      if (!newFont.LoadFile(fontFilePaths[newSelected].string())) {
+      if (!newFont.Load(data, hash)) {
         ImGui::OpenPopup("InvalidFont");
       } else {
         font = newFont;
         axisLimits = font.GetAxisInfos();
 
+        UiFontRequest(font.GetFamilyName());
+        UiFontRequest(font.GetSubFamilyName());
+
         magic_enum::enum_for_each<VariationAxis>([](const VariationAxis &axis) {
           if (!axisLimits[axis].has_value())
             return;
@@ -547,6 +1294,7 @@ void SceneDoUI(SDL_Window *window) {
     ImGui::Text("FreeType %d.%d.%d", FREETYPE_MAJOR, FREETYPE_MINOR,
                 FREETYPE_PATCH);
     ImGui::Text("Harfbuzz %s", HB_VERSION_STRING);
+    ImGui::Text("ICU %s", U_ICU_VERSION);
     ImGui::Text("Magic-Enum %d.%d.%d", MAGIC_ENUM_VERSION_MAJOR,
                 MAGIC_ENUM_VERSION_MINOR, MAGIC_ENUM_VERSION_PATCH);
     ImGui::Text("NLOHMANM-JSON %d.%d.%d", NLOHMANN_JSON_VERSION_MAJOR,
@@ -8,5 +8,6 @@ bool SceneInit();
 void SceneTick(SDL_Renderer *renderer);
 void SceneCleanUp();
 void SceneDoUI(SDL_Window *window);
+void SceneHandleEvent(const SDL_Event &event);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::filesystem::path &path) {
+  Close();
+
+  // Other handles may keep appending to the file while it is mapped.
+  file = CreateFileW(path.c_str(), GENERIC_READ,
+                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                     nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize)) {
+    Close();
+    return false;
+  }
+
+  size = static_cast<size_t>(fileSize.QuadPart);
+  isOpen = true;
+
+  if (size == 0) {
+    return true;
+  }
+
+  mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    Close();
+    return false;
+  }
+
+  data = static_cast<const uint8_t *>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size));
+  if (data == nullptr) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != nullptr) {
+    UnmapViewOfFile(data);
+  }
+  if (mapping != nullptr) {
+    CloseHandle(mapping);
+  }
+  if (file != nullptr) {
+    CloseHandle(file);
+  }
+
+  data = nullptr;
+  mapping = nullptr;
+  file = nullptr;
+  size = 0;
+  isOpen = false;
+}
+#else
+bool MappedFile::Open(const std::filesystem::path &path) {
+  Close();
+
+  file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+
+  struct stat status;
+  if (fstat(file, &status) != 0) {
+    Close();
+    return false;
+  }
+
+  size = static_cast<size_t>(status.st_size);
+  isOpen = true;
+
+  if (size == 0) {
+    return true;
+  }
+
+  auto address = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+  if (address == MAP_FAILED) {
+    Close();
+    return false;
+  }
+
+  data = static_cast<const uint8_t *>(address);
+
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != nullptr) {
+    munmap(const_cast<uint8_t *>(data), size);
+  }
+  if (file >= 0) {
+    close(file);
+  }
+
+  data = nullptr;
+  file = -1;
+  size = 0;
+  isOpen = false;
+}
+#endif
@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  bool Open(const std::filesystem::path &path);
+  void Close();
+
+  bool IsOpen() const { return isOpen; }
+
+  // Null when the file is empty.
+  const uint8_t *Data() const { return data; }
+  size_t Size() const { return size; }
+
+private:
+  bool isOpen{false};
+  const uint8_t *data{nullptr};
+  size_t size{0};
+
+#ifdef _WIN32
+  void *file{nullptr};
+  void *mapping{nullptr};
+#else
+  int file{-1};
+#endif
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "metrics_export.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <utf8cpp/utf8.h>
+
+using namespace nlohmann;
+
+namespace {
+json FontRecord(const Font &font) {
+  json js{};
+
+  js["type"] = "font";
+  js["family"] = font.GetFamilyName();
+  js["sub_family"] = font.GetSubFamilyName();
+  js["size"] = font.FontSize();
+  js["ascend"] = font.Ascend();
+  js["descend"] = font.Descend();
+  js["line_gap"] = font.LineGap();
+  js["line_height"] = font.LineHeight();
+
+  return js;
+}
+
+json GlyphRecord(const Font &font, const ShapedGlyph &glyph,
+                 const size_t &offset) {
+  json js{};
+
+  js["id"] = glyph.index;
+  js["cluster"] = offset + glyph.cluster;
+  js["x_advance"] = HBPosToFloat(glyph.xAdvance);
+  js["y_advance"] = HBPosToFloat(glyph.yAdvance);
+  js["x_offset"] = HBPosToFloat(glyph.xOffset);
+  js["y_offset"] = HBPosToFloat(glyph.yOffset);
+
+  // Left, bottom, right and top. The bearing is the top-left corner and the
+  // height goes down.
+  hb_glyph_extents_t extents{};
+  if (hb_font_get_glyph_extents(font.HbFont(), glyph.index, &extents)) {
+    js["ink"] = {
+        HBPosToFloat(extents.x_bearing),
+        HBPosToFloat(extents.y_bearing + extents.height),
+        HBPosToFloat(extents.x_bearing + extents.width),
+        HBPosToFloat(extents.y_bearing),
+    };
+  } else {
+    js["ink"] = nullptr;
+  }
+
+  return js;
+}
+
+bool ParseDirection(std::string_view name, hb_direction_t &direction) {
+  if (name == "ltr") {
+    direction = HB_DIRECTION_LTR;
+  } else if (name == "rtl") {
+    direction = HB_DIRECTION_RTL;
+  } else if (name == "ttb") {
+    direction = HB_DIRECTION_TTB;
+  } else {
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+MetricsExportStats ExportMetrics(Font &font, const LayoutOptions &options,
+                                 const hb_position_t &extent,
+                                 std::istream &input, std::ostream &output) {
+  MetricsExportStats stats;
+
+  if (!font.IsValid())
+    return stats;
+
+  output << FontRecord(font).dump() << '\n';
+
+  TextLayout layout;
+  std::string line;
+  std::string valid;
+  std::u16string text;
+
+  while (std::getline(input, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+
+    // A corpus may not be clean, invalid sequences become U+FFFD.
+    valid.clear();
+    utf8::replace_invalid(line.begin(), line.end(), std::back_inserter(valid));
+
+    text.clear();
+    utf8::utf8to16(valid.begin(), valid.end(), std::back_inserter(text));
+
+    layout.Update(font, text, options, extent);
+
+    for (const auto &paragraph : layout.Paragraphs()) {
+      for (size_t l = 0; l < paragraph.lines.size(); l++) {
+        const auto &layoutLine = paragraph.lines[l];
+
+        json js{};
+        js["type"] = "line";
+        js["paragraph"] = stats.paragraphs;
+        js["line"] = l;
+        js["start"] = layoutLine.start;
+        js["end"] = layoutLine.end;
+        js["advance"] = HBPosToFloat(layoutLine.advance);
+
+        auto glyphs = json::array();
+        for (const auto &run : layoutLine.runs) {
+          for (size_t i = run.glyphStart; i < run.glyphEnd; i++) {
+            glyphs.push_back(
+                GlyphRecord(font, run.shaped->glyphs[i], run.offset));
+          }
+        }
+        stats.glyphs += glyphs.size();
+        js["glyphs"] = std::move(glyphs);
+
+        output << js.dump() << '\n';
+        stats.lines++;
+      }
+    }
+
+    stats.paragraphs++;
+  }
+
+  output.flush();
+  return stats;
+}
+
+std::optional<MetricsOptions> ParseMetricsOptions(const int &argc,
+                                                  char **argv) {
+  std::optional<MetricsOptions> options;
+
+  for (int i = 1; i + 1 < argc; i++) {
+    if (std::string_view(argv[i]) == "--metrics") {
+      options.emplace().corpusPath = argv[++i];
+    }
+  }
+
+  if (!options.has_value())
+    return options;
+
+  for (int i = 1; i + 1 < argc; i++) {
+    const std::string_view arg = argv[i];
+
+    if (arg == "--metrics") {
+      i++;
+    } else if (arg == "--font") {
+      options->fontPath = argv[++i];
+    } else if (arg == "--output") {
+      options->outputPath = argv[++i];
+    } else if (arg == "--size") {
+      options->fontSize = std::atoi(argv[++i]);
+    } else if (arg == "--language") {
+      options->language = argv[++i];
+    } else if (arg == "--width") {
+      options->width = std::atoi(argv[++i]);
+    } else if (arg == "--direction" &&
+               !ParseDirection(argv[++i], options->direction)) {
+      spdlog::warn("Unknown direction {}, use ltr, rtl or ttb", argv[i]);
+    }
+  }
+
+  return options;
+}
+
+bool RunMetricsExport(const MetricsOptions &options) {
+  std::ifstream corpus(options.corpusPath, std::ios::in | std::ios::binary);
+  if (!corpus) {
+    spdlog::error("Unable to read {}", options.corpusPath.string());
+    return false;
+  }
+
+  if (!Font::Init()) {
+    spdlog::error("Unable to initialize FreeType");
+    return false;
+  }
+
+  bool isExported = false;
+  {
+    Font font;
+    if (font.LoadFile(options.fontPath.string())) {
+      font.SetFontSize(options.fontSize);
+
+      const LayoutOptions layoutOptions{
+          .direction = options.direction,
+          .language = options.language,
+      };
+      const hb_position_t extent = options.width > 0
+                                       ? FloatToHBPos(options.width)
+                                       : TextLayout::NO_WRAP;
+
+      std::ofstream file;
+      if (!options.outputPath.empty()) {
+        file.open(options.outputPath, std::ios::out | std::ios::binary);
+      }
+      auto &output = options.outputPath.empty() ? std::cout : file;
+
+      const auto stats =
+          ExportMetrics(font, layoutOptions, extent, corpus, output);
+      spdlog::info("Exported {} paragraphs, {} lines, {} glyphs",
+                   stats.paragraphs, stats.lines, stats.glyphs);
+      isExported = static_cast<bool>(output);
+    } else {
+      spdlog::error("Unable to load {}", options.fontPath.string());
+    }
+  }
+
+  Font::CleanUp();
+  return isExported;
+}
@@ -0,0 +1,55 @@
+#ifndef METRICS_EXPORT_HPP
+#define METRICS_EXPORT_HPP
+
+#include "font.hpp"
+#include "text_layout.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+
+struct MetricsExportStats {
+  size_t paragraphs{0};
+  size_t lines{0};
+  size_t glyphs{0};
+};
+
+/*
+ * Writes the layout of `input` as JSON Lines: one "font" record with the
+ * font metrics, then one "line" record per laid out line with its glyph ids,
+ * clusters, advances, offsets and ink bounds. Positions are in pixels with the
+ * Y axis going up, ink bounds are relative to the glyph origin.
+ *
+ * Every line of `input` is a paragraph, laid out and written before the next
+ * one is read, so a corpus of any size can be exported. The shape cache of
+ * the font bounds itself, so it does not grow with the corpus either.
+ */
+MetricsExportStats ExportMetrics(Font &font, const LayoutOptions &options,
+                                 const hb_position_t &extent,
+                                 std::istream &input, std::ostream &output);
+
+struct MetricsOptions {
+  std::filesystem::path corpusPath;
+  std::filesystem::path fontPath;
+
+  // Standard output when empty.
+  std::filesystem::path outputPath;
+
+  int fontSize{16};
+  hb_direction_t direction{HB_DIRECTION_LTR};
+  std::string language;
+
+  // Lines are broken at this many pixels, 0 keeps each paragraph on one line.
+  int width{0};
+};
+
+// Returns nothing unless `--metrics <corpus>` is on the command line.
+std::optional<MetricsOptions> ParseMetricsOptions(const int &argc,
+                                                  char **argv);
+
+// Exports the corpus without the UI. Returns false when an input is missing.
+bool RunMetricsExport(const MetricsOptions &options);
+
+#endif
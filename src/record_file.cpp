@@ -0,0 +1,312 @@
+#include "record_file.hpp"
+
+#include "hash.hpp"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace {
+constexpr uint32_t RECORD_MAGIC = 0x44434552; // "RECD"
+
+// Larger records are never stored, it also rejects garbage sizes.
+constexpr uint32_t MAX_KEY_SIZE = 1024;
+constexpr uint32_t MAX_PAYLOAD_SIZE = 64 * 1024 * 1024;
+
+struct FileHeader {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct RecordHeader {
+  uint32_t magic;
+  uint32_t keySize;
+  uint32_t payloadSize;
+  uint32_t reserved;
+
+  // Covers the header, with this field set to 0, the key and the payload.
+  uint64_t checksum;
+};
+
+// Both are written as they are, so they must not contain any padding.
+static_assert(sizeof(FileHeader) == 16);
+static_assert(sizeof(RecordHeader) == 24);
+
+constexpr size_t Align(const size_t &size) { return (size + 7) & ~size_t{7}; }
+
+size_t RecordSize(const RecordHeader &header) {
+  return Align(sizeof(RecordHeader) + header.keySize + header.payloadSize);
+}
+
+uint64_t Checksum(RecordHeader header, const uint8_t *key,
+                  const uint8_t *payload) {
+  header.checksum = 0;
+
+  auto checksum = Hash64(&header, sizeof(header));
+  checksum = Hash64(key, header.keySize, checksum);
+  return Hash64(payload, header.payloadSize, checksum);
+}
+
+// Returns the header of the record at `offset`, if the record is complete and
+// intact.
+std::optional<RecordHeader> ReadRecord(const MappedFile &mapping,
+                                       const size_t &offset) {
+  if (offset + sizeof(RecordHeader) > mapping.Size())
+    return std::nullopt;
+
+  RecordHeader header;
+  std::memcpy(&header, mapping.Data() + offset, sizeof(header));
+
+  if (header.magic != RECORD_MAGIC || header.keySize > MAX_KEY_SIZE ||
+      header.payloadSize > MAX_PAYLOAD_SIZE)
+    return std::nullopt;
+
+  if (offset + sizeof(RecordHeader) + header.keySize + header.payloadSize >
+      mapping.Size())
+    return std::nullopt;
+
+  const auto *key = mapping.Data() + offset + sizeof(RecordHeader);
+  if (Checksum(header, key, key + header.keySize) != header.checksum)
+    return std::nullopt;
+
+  return header;
+}
+} // namespace
+
+RecordFile::RecordFile(const Magic &magic, const uint32_t &version)
+    : magic(magic), version(version) {}
+
+RecordFile::~RecordFile() { Close(); }
+
+bool RecordFile::Open(const std::filesystem::path &path,
+                      const size_t &maxSize) {
+  std::scoped_lock lock(mutex);
+
+  mapping.Close();
+  output.close();
+  index.clear();
+
+  RecordFile::path = path;
+  RecordFile::maxSize = maxSize;
+
+  return Load();
+}
+
+void RecordFile::Close() {
+  std::scoped_lock lock(mutex);
+
+  mapping.Close();
+  output.close();
+  index.clear();
+  fileSize = 0;
+}
+
+bool RecordFile::IsOpen() const {
+  std::scoped_lock lock(mutex);
+  return output.is_open();
+}
+
+std::optional<std::vector<uint8_t>>
+RecordFile::Find(std::span<const uint8_t> key) {
+  std::scoped_lock lock(mutex);
+
+  if (!output.is_open())
+    return std::nullopt;
+
+  auto iter = index.find(Hash64(key.data(), key.size()));
+  if (iter == index.end()) {
+    misses++;
+    return std::nullopt;
+  }
+
+  const auto offset = iter->second;
+
+  // Records appended since the file was mapped are not visible yet.
+  if (offset + sizeof(RecordHeader) > mapping.Size()) {
+    Remap();
+  }
+
+  auto header = ReadRecord(mapping, offset);
+  if (!header.has_value()) {
+    spdlog::warn("Record at {} of {} is corrupted.", offset, path.string());
+    index.erase(iter);
+    misses++;
+
+    return std::nullopt;
+  }
+
+  const auto *recordKey = mapping.Data() + offset + sizeof(RecordHeader);
+  if (!std::ranges::equal(key, std::span(recordKey, header->keySize))) {
+    misses++;
+    return std::nullopt;
+  }
+
+  hits++;
+
+  const auto *payload = recordKey + header->keySize;
+  return std::vector<uint8_t>(payload, payload + header->payloadSize);
+}
+
+void RecordFile::Insert(std::span<const uint8_t> key,
+                        std::span<const uint8_t> payload) {
+  std::scoped_lock lock(mutex);
+
+  if (!output.is_open() || key.size() > MAX_KEY_SIZE ||
+      payload.size() > MAX_PAYLOAD_SIZE)
+    return;
+
+  const auto keyHash = Hash64(key.data(), key.size());
+  if (index.contains(keyHash))
+    return;
+
+  RecordHeader header{
+      .magic = RECORD_MAGIC,
+      .keySize = static_cast<uint32_t>(key.size()),
+      .payloadSize = static_cast<uint32_t>(payload.size()),
+      .reserved = 0,
+      .checksum = 0,
+  };
+  header.checksum = Checksum(header, key.data(), payload.data());
+
+  const size_t recordSize = RecordSize(header);
+  if (fileSize + recordSize > maxSize) {
+    spdlog::info("{} reached {} bytes, starting over.", path.string(),
+                 maxSize);
+    if (!Reset())
+      return;
+  }
+
+  constexpr std::array<char, 8> padding{};
+
+  output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char *>(key.data()), key.size());
+  output.write(reinterpret_cast<const char *>(payload.data()),
+               payload.size());
+  output.write(padding.data(),
+               recordSize - sizeof(header) - key.size() - payload.size());
+  output.flush();
+
+  if (!output) {
+    spdlog::error("Unable to write {}, disabling it.", path.string());
+    output.close();
+    return;
+  }
+
+  index[keyHash] = fileSize;
+  fileSize += recordSize;
+}
+
+void RecordFile::Clear() {
+  std::scoped_lock lock(mutex);
+
+  if (output.is_open()) {
+    Reset();
+  }
+}
+
+size_t RecordFile::FileSize() const {
+  std::scoped_lock lock(mutex);
+  return fileSize;
+}
+
+size_t RecordFile::RecordCount() const {
+  std::scoped_lock lock(mutex);
+  return index.size();
+}
+
+size_t RecordFile::HitCount() const {
+  std::scoped_lock lock(mutex);
+  return hits;
+}
+
+size_t RecordFile::MissCount() const {
+  std::scoped_lock lock(mutex);
+  return misses;
+}
+
+/*
+ * Indexes the records of the file. Everything after the first record that is
+ * incomplete or fails its checksum is cut off, which also drops the partial
+ * record of a session that did not exit cleanly.
+ */
+bool RecordFile::Load() {
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path, ec);
+
+  if (ec || size < sizeof(FileHeader) || size > maxSize) {
+    return Reset();
+  }
+
+  if (!Remap()) {
+    return false;
+  }
+
+  FileHeader header;
+  std::memcpy(&header, mapping.Data(), sizeof(header));
+  if (header.magic != magic || header.version != version) {
+    spdlog::info("{} has an unknown format, starting over.", path.string());
+    return Reset();
+  }
+
+  size_t offset = sizeof(FileHeader);
+  while (auto record = ReadRecord(mapping, offset)) {
+    const auto *key = mapping.Data() + offset + sizeof(RecordHeader);
+    index[Hash64(key, record->keySize)] = offset;
+    offset += RecordSize(*record);
+  }
+
+  if (offset < mapping.Size()) {
+    spdlog::warn("{} is corrupted after {} bytes, truncating.", path.string(),
+                 offset);
+
+    // A mapped file cannot be resized on every platform.
+    mapping.Close();
+    std::filesystem::resize_file(path, offset, ec);
+    if (ec || !Remap()) {
+      return Reset();
+    }
+  }
+
+  fileSize = offset;
+
+  output.open(path, std::ios::binary | std::ios::app);
+  spdlog::info("{} opened with {} records.", path.string(), index.size());
+
+  return output.is_open();
+}
+
+// Replaces the file with an empty one.
+bool RecordFile::Reset() {
+  mapping.Close();
+  output.close();
+  index.clear();
+  fileSize = 0;
+
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const FileHeader header{
+        .magic = magic,
+        .version = version,
+        .reserved = 0,
+    };
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    if (!file) {
+      spdlog::error("Unable to create {}.", path.string());
+      return false;
+    }
+  }
+
+  fileSize = sizeof(FileHeader);
+  output.open(path, std::ios::binary | std::ios::app);
+
+  return Remap() && output.is_open();
+}
+
+bool RecordFile::Remap() {
+  if (output.is_open()) {
+    output.flush();
+  }
+
+  return mapping.Open(path);
+}
@@ -0,0 +1,79 @@
+#ifndef RECORD_FILE_HPP
+#define RECORD_FILE_HPP
+
+#include "mapped_file.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * A file of records, each a key and a payload, used by the on-disk caches.
+ * Records are only ever appended to the file, and read back through a memory
+ * mapping of it. Every record carries a checksum: on open, the file is cut at
+ * the first record that does not check out. When the file would grow past its
+ * size limit it is emptied and starts over.
+ *
+ * Can be used from any thread.
+ */
+class RecordFile {
+public:
+  using Magic = std::array<char, 8>;
+
+  RecordFile(const Magic &magic, const uint32_t &version);
+  RecordFile(const RecordFile &) = delete;
+  RecordFile &operator=(const RecordFile &) = delete;
+  ~RecordFile();
+
+  bool Open(const std::filesystem::path &path, const size_t &maxSize);
+  void Close();
+
+  bool IsOpen() const;
+
+  std::optional<std::vector<uint8_t>> Find(std::span<const uint8_t> key);
+  void Insert(std::span<const uint8_t> key, std::span<const uint8_t> payload);
+
+  void Clear();
+
+  size_t FileSize() const;
+  size_t RecordCount() const;
+  size_t HitCount() const;
+  size_t MissCount() const;
+
+private:
+  bool Load();
+  bool Reset();
+  bool Remap();
+
+  const Magic magic;
+  const uint32_t version;
+
+  mutable std::mutex mutex;
+
+  std::filesystem::path path;
+  size_t maxSize{0};
+
+  MappedFile mapping;
+  std::ofstream output;
+  size_t fileSize{0};
+
+  // Offsets of the records in the file, by the hash of their key.
+  std::unordered_map<uint64_t, size_t> index;
+
+  size_t hits{0};
+  size_t misses{0};
+};
+
+// Views a key struct as bytes. Keys must not contain padding.
+template <class T> std::span<const uint8_t> AsBytes(const T &value) {
+  static_assert(std::has_unique_object_representations_v<T>);
+  return {reinterpret_cast<const uint8_t *>(&value), sizeof(T)};
+}
+
+#endif
@@ -0,0 +1,426 @@
+#include "regression.hpp"
+
+#include "cluster_index.hpp"
+#include "debug_settings.hpp"
+#include "font.hpp"
+#include "frame_arena.hpp"
+#include "hash.hpp"
+#include "io_util.hpp"
+#include "text_layout.hpp"
+#include "text_renderer.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <utf8cpp/utf8.h>
+#include <vector>
+
+namespace {
+constexpr int CANVAS_WIDTH = 512;
+constexpr int CANVAS_HEIGHT = 256;
+
+constexpr std::array SIZES{12, 24, 48};
+
+constexpr SDL_Color BACKGROUND{0xFF, 0xFF, 0xFF, 0xFF};
+constexpr SDL_Color FOREGROUND{0x00, 0x00, 0x00, 0xFF};
+
+// Drawn over the dimmed rendering where a pixel differs.
+constexpr SDL_Color DIFF_COLOR{0xFF, 0x00, 0x00, 0xFF};
+
+struct Sample {
+  std::string_view name;
+  std::string_view font;
+  std::string_view text;
+  hb_script_t script;
+  std::string_view language;
+  TextDirection direction;
+};
+
+// Covers the bundled fonts, both bidi directions, vertical text and scripts
+// with complex shaping.
+const std::array samples{
+    Sample{"latin", "NotoSans-Regular.ttf",
+           "Hamburgefonstiv 0123456789\nfi fl ffi AVA To. Wa, \"quotes\"",
+           HB_SCRIPT_LATIN, "en-US", TextDirection::LeftToRight},
+    Sample{"arabic", "NotoSansArabic-Regular.ttf",
+           "\xd8\xa7\xd9\x84\xd8\xae\xd8\xb7 \xd8\xa7\xd9\x84\xd8\xb9\xd8\xb1"
+           "\xd8\xa8\xd9\x8a \xd9\xa1\xd9\xa2\xd9\xa3",
+           HB_SCRIPT_ARABIC, "ar-SA", TextDirection::RightToLeft},
+    Sample{"thai", "NotoSansThai-Regular.ttf",
+           "\xe0\xb8\xa0\xe0\xb8\xb2\xe0\xb8\xa9\xe0\xb8\xb2\xe0\xb9\x84\xe0"
+           "\xb8\x97\xe0\xb8\xa2 \xe0\xb8\x99\xe0\xb9\x89\xe0\xb8\xb3\xe0\xb9"
+           "\x80\xe0\xb8\x87\xe0\xb8\xb4\xe0\xb8\x99",
+           HB_SCRIPT_THAI, "th-TH", TextDirection::LeftToRight},
+    Sample{"japanese", "NotoSansJP-Regular.ttf",
+           "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87\xe7"
+           "\xab\xa0\xe3\x80\x81\xe3\x82\xab\xe3\x82\xbf\xe3\x82\xab\xe3\x83"
+           "\x8a\xe3\x80\x82",
+           HB_SCRIPT_INVALID, "ja-JP", TextDirection::LeftToRight},
+    Sample{"japanese_vertical", "NotoSansJP-Regular.ttf",
+           "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87\xe7"
+           "\xab\xa0\xe3\x80\x81\xe3\x82\xab\xe3\x82\xbf\xe3\x82\xab\xe3\x83"
+           "\x8a\xe3\x80\x82",
+           HB_SCRIPT_INVALID, "ja-JP", TextDirection::TopToBottom},
+    Sample{"korean", "NotoSansKR-Regular.ttf",
+           "\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4 \xeb\xac\xb8\xec\x9e\xa5",
+           HB_SCRIPT_HANGUL, "ko-KR", TextDirection::LeftToRight},
+    Sample{"chinese_simplified", "NotoSansSC-Regular.ttf",
+           "\xe7\xae\x80\xe4\xbd\x93\xe4\xb8\xad\xe6\x96\x87",
+           HB_SCRIPT_HAN, "zh-CN", TextDirection::LeftToRight},
+    Sample{"chinese_traditional", "NotoSansTC-Regular.ttf",
+           "\xe7\xb9\x81\xe9\xab\x94\xe4\xb8\xad\xe6\x96\x87",
+           HB_SCRIPT_HAN, "zh-TW", TextDirection::LeftToRight},
+};
+
+struct FontData {
+  std::shared_ptr<const std::vector<char>> data;
+  uint64_t hash{0};
+};
+
+struct Case {
+  const Sample *sample;
+  int size;
+
+  std::string Name() const {
+    return std::string(sample->name) + "_" + std::to_string(size);
+  }
+};
+
+hb_direction_t ToHbDirection(const TextDirection &direction) {
+  switch (direction) {
+  case TextDirection::TopToBottom:
+    return HB_DIRECTION_TTB;
+
+  case TextDirection::RightToLeft:
+    return HB_DIRECTION_RTL;
+
+  default:
+    return HB_DIRECTION_LTR;
+  }
+}
+
+using SurfacePtr = std::unique_ptr<SDL_Surface, decltype(&SDL_DestroySurface)>;
+
+SurfacePtr MakeSurface(SDL_Surface *surface) {
+  return {surface, &SDL_DestroySurface};
+}
+
+// Lays out and draws the sample with the renderer. A layout kept between
+// calls is updated like the one of the scene.
+void Draw(SDL_Renderer *renderer, const Sample &sample, Font &font,
+          TextLayout &layout) {
+  const LayoutOptions options{
+      .direction = ToHbDirection(sample.direction),
+      .script = sample.script,
+      .language = std::string(sample.language),
+  };
+
+  std::u16string text;
+  utf8::utf8to16(sample.text.begin(), sample.text.end(),
+                 std::back_inserter(text));
+
+  const bool isVertical = sample.direction == TextDirection::TopToBottom;
+  layout.Update(font, text, options,
+                FloatToHBPos(isVertical ? CANVAS_HEIGHT : CANVAS_WIDTH));
+
+  DebugSettings debug{};
+  ClusterIndex index;
+
+  switch (sample.direction) {
+  case TextDirection::LeftToRight:
+    TextRenderLeftToRight(renderer, debug, font, layout, FOREGROUND, index);
+    break;
+  case TextDirection::TopToBottom:
+    TextRenderTopToBottom(renderer, debug, font, layout, FOREGROUND, index);
+    break;
+  case TextDirection::RightToLeft:
+    TextRenderRightToLeft(renderer, debug, font, layout, FOREGROUND, index);
+    break;
+  }
+}
+
+// The SDL render API and the frame arena of the debug overlay are only used
+// from the main thread, so the cases render one after the other.
+SurfacePtr Render(const Case &c, const FontData &fontData) {
+  auto surface = MakeSurface(
+      SDL_CreateSurface(CANVAS_WIDTH, CANVAS_HEIGHT, SDL_PIXELFORMAT_RGBA32));
+  if (!surface)
+    return surface;
+
+  auto *renderer = SDL_CreateSoftwareRenderer(surface.get());
+  if (renderer == nullptr)
+    return MakeSurface(nullptr);
+
+  SDL_SetRenderDrawColor(renderer, BACKGROUND.r, BACKGROUND.g, BACKGROUND.b,
+                         BACKGROUND.a);
+  SDL_RenderClear(renderer);
+
+  {
+    // Destroyed before the renderer, it owns textures of it.
+    Font font;
+    font.Load(fontData.data, fontData.hash);
+    font.SetFontSize(c.size);
+
+    TextLayout layout;
+    Draw(renderer, *c.sample, font, layout);
+  }
+
+  SDL_FlushRenderer(renderer);
+  SDL_DestroyRenderer(renderer);
+
+  return surface;
+}
+
+// Does what the scene does when the file of the displayed font is removed
+// from the directory: the font is replaced by a default one, and the layout
+// is updated with it. The replaced face must be gone, not read once freed.
+bool CheckRemovedFont(const RegressionOptions &options) {
+  constexpr std::string_view name = "removed_font";
+  const auto &sample = samples.front();
+
+  std::error_code ec;
+  const auto path = std::filesystem::temp_directory_path(ec) /
+                    "font-render-tester-removed.ttf";
+  std::filesystem::copy_file(options.fontDir / sample.font, path,
+                             std::filesystem::copy_options::overwrite_existing,
+                             ec);
+  if (ec) {
+    spdlog::error("{}: unable to copy the font: {}", name, ec.message());
+    return false;
+  }
+
+  auto surface = MakeSurface(
+      SDL_CreateSurface(CANVAS_WIDTH, CANVAS_HEIGHT, SDL_PIXELFORMAT_RGBA32));
+  auto *renderer =
+      surface ? SDL_CreateSoftwareRenderer(surface.get()) : nullptr;
+  if (renderer == nullptr) {
+    spdlog::error("{}: unable to render: {}", name, SDL_GetError());
+    std::filesystem::remove(path, ec);
+    return false;
+  }
+
+  bool isLoaded = false;
+  bool isReleased = false;
+  {
+    Font font;
+    TextLayout layout;
+
+    isLoaded = font.LoadFile(path.string());
+    font.SetFontSize(SIZES.front());
+    Draw(renderer, sample, font, layout);
+
+    std::filesystem::remove(path, ec);
+    font = Font();
+
+    isReleased = !font.IsValid() && font.HbFont() == nullptr &&
+                 font.GlyphCount() == 0;
+    Draw(renderer, sample, font, layout);
+  }
+
+  SDL_DestroyRenderer(renderer);
+
+  if (!isLoaded) {
+    spdlog::error("{}: unable to load {}", name, path.string());
+    return false;
+  }
+  if (!isReleased) {
+    spdlog::error("{}: the font is still valid once replaced", name);
+    return false;
+  }
+
+  return true;
+}
+
+// Both surfaces are RGBA32 of the canvas size. Fills `diff` and returns the
+// count of pixels differing by more than `tolerance` in a channel.
+size_t Compare(const SDL_Surface &actual, const SDL_Surface &golden,
+               const int &tolerance, SDL_Surface &diff) {
+  size_t count = 0;
+
+  for (int y = 0; y < actual.h; y++) {
+    const auto *a = static_cast<const uint8_t *>(actual.pixels) +
+                    y * actual.pitch;
+    const auto *g = static_cast<const uint8_t *>(golden.pixels) +
+                    y * golden.pitch;
+    auto *d = static_cast<uint8_t *>(diff.pixels) + y * diff.pitch;
+
+    for (int x = 0; x < actual.w * 4; x += 4) {
+      int delta = 0;
+      for (int c = 0; c < 3; c++) {
+        delta = std::max(delta, std::abs(a[x + c] - g[x + c]));
+      }
+
+      if (delta > tolerance) {
+        count++;
+        d[x] = DIFF_COLOR.r;
+        d[x + 1] = DIFF_COLOR.g;
+        d[x + 2] = DIFF_COLOR.b;
+      } else {
+        // A quarter of the contrast, so the text stays readable.
+        for (int c = 0; c < 3; c++) {
+          d[x + c] = static_cast<uint8_t>(192 + a[x + c] / 4);
+        }
+      }
+      d[x + 3] = 0xFF;
+    }
+  }
+
+  return count;
+}
+
+bool SaveBMP(SDL_Surface *surface, const std::filesystem::path &path) {
+  if (!SDL_SaveBMP(surface, path.string().c_str())) {
+    spdlog::error("Unable to write {}: {}", path.string(), SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+bool RunCase(const Case &c, const FontData &fontData,
+             const RegressionOptions &options) {
+  const auto name = c.Name();
+  const auto goldenPath = options.goldenDir / (name + ".bmp");
+
+  auto actual = Render(c, fontData);
+  if (!actual) {
+    spdlog::error("{}: unable to render: {}", name, SDL_GetError());
+    return false;
+  }
+
+  if (options.isUpdating) {
+    return SaveBMP(actual.get(), goldenPath);
+  }
+
+  auto loaded = MakeSurface(SDL_LoadBMP(goldenPath.string().c_str()));
+  if (!loaded) {
+    spdlog::error("{}: no golden image at {}", name, goldenPath.string());
+    SaveBMP(actual.get(), options.outputDir / (name + ".bmp"));
+    return false;
+  }
+
+  auto golden =
+      MakeSurface(SDL_ConvertSurface(loaded.get(), SDL_PIXELFORMAT_RGBA32));
+  if (!golden || golden->w != actual->w || golden->h != actual->h) {
+    spdlog::error("{}: the golden image is not {}x{}", name, actual->w,
+                  actual->h);
+    SaveBMP(actual.get(), options.outputDir / (name + ".bmp"));
+    return false;
+  }
+
+  auto diff = MakeSurface(
+      SDL_CreateSurface(actual->w, actual->h, SDL_PIXELFORMAT_RGBA32));
+  if (!diff)
+    return false;
+
+  const auto count = Compare(*actual, *golden, options.tolerance, *diff);
+  if (count == 0)
+    return true;
+
+  spdlog::error("{}: {} pixels differ", name, count);
+  SaveBMP(actual.get(), options.outputDir / (name + ".bmp"));
+  SaveBMP(diff.get(), options.outputDir / (name + ".diff.bmp"));
+
+  return false;
+}
+} // namespace
+
+std::optional<RegressionOptions> ParseRegressionOptions(const int &argc,
+                                                        char **argv) {
+  std::optional<RegressionOptions> options;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--regression" && hasValue) {
+      options.emplace().goldenDir = argv[++i];
+    }
+  }
+
+  if (!options.has_value())
+    return options;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--update") {
+      options->isUpdating = true;
+    } else if (arg == "--fonts" && hasValue) {
+      options->fontDir = argv[++i];
+    } else if (arg == "--output" && hasValue) {
+      options->outputDir = argv[++i];
+    } else if (arg == "--tolerance" && hasValue) {
+      options->tolerance = std::atoi(argv[++i]);
+    }
+  }
+
+  return options;
+}
+
+bool RunRegression(const RegressionOptions &options) {
+  if (!Font::Init()) {
+    spdlog::error("Unable to initialize FreeType");
+    return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(
+      options.isUpdating ? options.goldenDir : options.outputDir, ec);
+
+  // Every case of a font shares its data.
+  std::map<std::string_view, FontData> fonts;
+  for (const auto &sample : samples) {
+    auto &font = fonts[sample.font];
+    if (font.data)
+      continue;
+
+    const auto path = options.fontDir / sample.font;
+    font.data = std::make_shared<const std::vector<char>>(
+        LoadFile<std::vector<char>>(path, std::ios::in | std::ios::binary));
+    if (font.data->empty()) {
+      spdlog::error("Unable to load {}", path.string());
+      Font::CleanUp();
+      return false;
+    }
+    font.hash = Hash64(font.data->data(), font.data->size());
+  }
+
+  std::vector<Case> cases;
+  for (const auto &sample : samples) {
+    for (const auto &size : SIZES) {
+      cases.push_back({&sample, size});
+    }
+  }
+
+  size_t failures = 0;
+  for (const auto &c : cases) {
+    if (!RunCase(c, fonts.at(c.sample->font), options)) {
+      failures++;
+    }
+
+    // Each case stands for a frame of the debug overlay.
+    FrameArena::Shared().Reset();
+  }
+
+  // Not an image, so there is nothing to update.
+  const bool isRemovedFontReleased =
+      options.isUpdating || CheckRemovedFont(options);
+  FrameArena::Shared().Reset();
+
+  Font::CleanUp();
+
+  if (options.isUpdating) {
+    spdlog::info("Wrote {} golden images to {}", cases.size(),
+                 options.goldenDir.string());
+  } else {
+    spdlog::info("{} of {} cases passed", cases.size() - failures,
+                 cases.size());
+  }
+
+  return failures == 0 && isRemovedFontReleased;
+}
@@ -0,0 +1,36 @@
+#ifndef REGRESSION_HPP
+#define REGRESSION_HPP
+
+#include <filesystem>
+#include <optional>
+
+struct RegressionOptions {
+  std::filesystem::path fontDir{"fonts"};
+  std::filesystem::path goldenDir;
+  std::filesystem::path outputDir{"regression_output"};
+
+  // Writes the rendered images as the new goldens instead of comparing.
+  bool isUpdating{false};
+
+  // The largest difference of a channel still counted as equal.
+  int tolerance{2};
+};
+
+// Returns nothing unless `--regression <golden dir>` is on the command line.
+std::optional<RegressionOptions> ParseRegressionOptions(const int &argc,
+                                                        char **argv);
+
+/*
+ * Renders every case of the regression matrix (sample text, with its font,
+ * script and direction, times the sizes) through the text renderers into
+ * software surfaces, and compares them with the BMP goldens pixel by pixel.
+ * A window, a GPU nor the UI are needed. The cases render on the calling
+ * thread, which must be the main thread. The rendered image and a diff image
+ * of each failing case go to the output directory. Also checks that a font
+ * replaced by a default one, as when its file is removed while displayed,
+ * releases its face. Returns true when every case matched and the check
+ * passed.
+ */
+bool RunRegression(const RegressionOptions &options);
+
+#endif
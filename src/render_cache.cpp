@@ -0,0 +1,75 @@
+#include "render_cache.hpp"
+
+#include <spdlog/spdlog.h>
+
+RenderCache::~RenderCache() { Release(); }
+
+bool RenderCache::Begin(SDL_Renderer *renderer, const int &newWidth,
+                        const int &newHeight) {
+  if (newWidth <= 0 || newHeight <= 0)
+    return false;
+
+  if (isUnsupported) {
+    drawCount++;
+    return true;
+  }
+
+  if (texture == nullptr || width != newWidth || height != newHeight) {
+    Release();
+
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                SDL_TEXTUREACCESS_TARGET, newWidth, newHeight);
+    if (texture == nullptr) {
+      spdlog::warn("Unable to create a render target, drawing without it: {}",
+                   SDL_GetError());
+      isUnsupported = true;
+      drawCount++;
+      return true;
+    }
+
+    // Fully covered by the background, nothing to blend with.
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+
+    width = newWidth;
+    height = newHeight;
+    isDirty = true;
+  }
+
+  if (!isDirty) {
+    hitCount++;
+    return false;
+  }
+
+  SDL_SetRenderTarget(renderer, texture);
+  drawCount++;
+
+  return true;
+}
+
+void RenderCache::End(SDL_Renderer *renderer) {
+  if (texture == nullptr)
+    return;
+
+  SDL_SetRenderTarget(renderer, nullptr);
+  isDirty = false;
+}
+
+void RenderCache::Draw(SDL_Renderer *renderer) const {
+  if (texture == nullptr)
+    return;
+
+  const SDL_FRect dst{0, 0, static_cast<float>(width),
+                      static_cast<float>(height)};
+  SDL_RenderTexture(renderer, texture, nullptr, &dst);
+}
+
+void RenderCache::Release() {
+  if (texture != nullptr) {
+    SDL_DestroyTexture(texture);
+    texture = nullptr;
+  }
+
+  width = 0;
+  height = 0;
+  isDirty = true;
+}
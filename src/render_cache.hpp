@@ -0,0 +1,44 @@
+#ifndef RENDER_CACHE_HPP
+#define RENDER_CACHE_HPP
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+
+/*
+ * A render target holding what a view drew last. The view is only drawn
+ * again when it is invalidated or resized, otherwise the target is copied to
+ * the screen as is.
+ */
+class RenderCache {
+public:
+  RenderCache() = default;
+  RenderCache(const RenderCache &) = delete;
+  RenderCache &operator=(const RenderCache &) = delete;
+  ~RenderCache();
+
+  // Returns true when the view has to be drawn, in which case the target is
+  // bound until End. Falls back to drawing on the screen without a target.
+  bool Begin(SDL_Renderer *renderer, const int &width, const int &height);
+  void End(SDL_Renderer *renderer);
+
+  // Copies the target at the origin of the current viewport.
+  void Draw(SDL_Renderer *renderer) const;
+
+  void Invalidate() { isDirty = true; }
+  void Release();
+
+  size_t DrawCount() const { return drawCount; }
+  size_t HitCount() const { return hitCount; }
+
+private:
+  SDL_Texture *texture{nullptr};
+  int width{0};
+  int height{0};
+  bool isDirty{true};
+  bool isUnsupported{false};
+
+  size_t drawCount{0};
+  size_t hitCount{0};
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "render_mode.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <magic_enum/magic_enum.hpp>
+
+FT_Int32 RenderMode::LoadFlags() const {
+  FT_Int32 flags = 0;
+
+  switch (hinting) {
+  case Hinting::Normal:
+    flags |= FT_LOAD_TARGET_NORMAL;
+    break;
+  case Hinting::Light:
+    flags |= FT_LOAD_TARGET_LIGHT;
+    break;
+  case Hinting::None:
+    flags |= FT_LOAD_NO_HINTING;
+    break;
+  case Hinting::Mono:
+    flags |= FT_LOAD_TARGET_MONO;
+    break;
+  }
+
+  switch (autohinter) {
+  case Autohinter::Default:
+    break;
+  case Autohinter::Forced:
+    flags |= FT_LOAD_FORCE_AUTOHINT;
+    break;
+  case Autohinter::Disabled:
+    flags |= FT_LOAD_NO_AUTOHINT;
+    break;
+  }
+
+  return flags;
+}
+
+uint32_t RenderMode::Key() const {
+  const auto gammaOffset =
+      static_cast<int16_t>(std::lround(gamma * 100.0f) - 100);
+
+  return static_cast<uint32_t>(hinting) |
+         static_cast<uint32_t>(autohinter) << 4 |
+         static_cast<uint32_t>(static_cast<uint16_t>(gammaOffset)) << 16;
+}
+
+std::string RenderMode::Name() const {
+  std::string name{magic_enum::enum_name(hinting)};
+
+  if (autohinter != Autohinter::Default) {
+    name += autohinter == Autohinter::Forced ? " +autohint" : " -autohint";
+  }
+
+  if (gamma != 1.0f) {
+    char text[16];
+    std::snprintf(text, sizeof(text), " g%.2f", gamma);
+    name += text;
+  }
+
+  return name;
+}
@@ -0,0 +1,45 @@
+#ifndef RENDER_MODE_HPP
+#define RENDER_MODE_HPP
+
+#include <cstdint>
+#include <string>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// The first value of each enum is the FreeType default.
+enum class Hinting {
+  Normal,
+  Light,
+  None,
+  Mono,
+};
+
+enum class Autohinter {
+  // The autohinter is used for fonts without native hinting.
+  Default,
+  Forced,
+  Disabled,
+};
+
+// How the glyphs are rasterized.
+struct RenderMode {
+  Hinting hinting{Hinting::Normal};
+  Autohinter autohinter{Autohinter::Default};
+
+  // Applied to the coverage, 1 keeps it linear and larger values darken it.
+  float gamma{1.0f};
+
+  bool operator==(const RenderMode &) const = default;
+
+  // To combine with FT_LOAD_RENDER.
+  FT_Int32 LoadFlags() const;
+
+  // Identifies the mode in the glyph caches, 0 for the default mode. Gamma is
+  // kept to two decimals.
+  uint32_t Key() const;
+
+  std::string Name() const;
+};
+
+#endif
@@ -0,0 +1,334 @@
+#include "render_mode_view.hpp"
+
+#include "colors.hpp"
+#include "glyph_atlas.hpp"
+#include "layout_job.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <imgui.h>
+#include <magic_enum/magic_enum_all.hpp>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace {
+constexpr int BAND_PADDING = 8;
+
+// The atlas is dropped and refilled once it grows past this many pages.
+constexpr size_t MAX_ATLAS_PAGES = 16;
+
+struct Band {
+  uint64_t id{0};
+
+  RenderMode mode;
+  bool isVisible{true};
+
+  std::shared_ptr<LayoutWorker> worker{std::make_shared<LayoutWorker>()};
+  std::future<LayoutJobOutput> job;
+  LayoutJobInput submitted;
+  bool isSubmitted{false};
+  bool isAtlasStale{false};
+
+  LayoutJobOutput result;
+};
+
+std::vector<Band> bands;
+uint64_t nextBandId = 1;
+
+// The font data the workers were created for.
+std::shared_ptr<const std::vector<char>> fontData;
+uint64_t fontHash = 0;
+
+// Jobs of replaced workers, which still own a font until they finish.
+std::vector<std::future<LayoutJobOutput>> retiredJobs;
+
+// Keyed by the band, so every mode has its own glyphs.
+GlyphAtlas atlas;
+
+bool IsJobRunning(const Band &band) { return band.job.valid(); }
+
+void AddBand(const RenderMode &mode) {
+  bands.push_back({.id = nextBandId++, .mode = mode});
+}
+
+// The modes compared most often.
+void AddDefaultBands() {
+  AddBand({.hinting = Hinting::None});
+  AddBand({.hinting = Hinting::Light});
+  AddBand({.hinting = Hinting::Normal});
+  AddBand({.hinting = Hinting::Normal, .autohinter = Autohinter::Forced});
+}
+
+void RetireJob(Band &band) {
+  std::erase_if(retiredJobs, [](const auto &job) {
+    return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  });
+
+  if (IsJobRunning(band)) {
+    retiredJobs.push_back(std::move(band.job));
+  }
+}
+
+void ResetWorkers(const Font &font) {
+  for (auto &band : bands) {
+    RetireJob(band);
+    band.worker = std::make_shared<LayoutWorker>();
+    band.isSubmitted = false;
+    band.result = {};
+  }
+
+  fontData = font.Data();
+  fontHash = font.ContentHash();
+}
+
+void CollectResult(SDL_Renderer *renderer, Band &band) {
+  if (!IsJobRunning(band) ||
+      band.job.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+
+  band.result = band.job.get();
+  UploadJobBitmaps(renderer, atlas, band.id, band.result);
+}
+
+void Submit(Band &band, const LayoutJobInput &input) {
+  if (IsJobRunning(band))
+    return;
+
+  if (band.isSubmitted && !band.isAtlasStale && band.submitted == input)
+    return;
+
+  band.job = ThreadPool::Shared().Submit(
+      [worker = band.worker, data = fontData, hash = fontHash, input,
+       isAtlasStale = band.isAtlasStale]() {
+        if (!worker->font) {
+          worker->font = std::make_unique<Font>();
+          worker->font->Load(data, hash);
+        }
+
+        return RunLayoutJob(*worker, input, isAtlasStale);
+      });
+
+  band.submitted = input;
+  band.isSubmitted = true;
+  band.isAtlasStale = false;
+}
+
+void DrawBand(SDL_Renderer *renderer, DebugSettings &debug, const Band &band,
+              const SDL_Color &color) {
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+
+  SDL_FRect border{0, 0, static_cast<float>(bound.w),
+                   static_cast<float>(bound.h)};
+  SDL_SetRenderDrawColor(renderer, comparisonCellBorderColor.r,
+                         comparisonCellBorderColor.g,
+                         comparisonCellBorderColor.b,
+                         comparisonCellBorderColor.a);
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  SDL_RenderRect(renderer, &border);
+
+  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+  SDL_RenderDebugText(renderer, BAND_PADDING, BAND_PADDING,
+                      band.mode.Name().c_str());
+
+  const auto &result = band.result;
+  if (!result.isValid)
+    return;
+
+  DebugOverlay overlay(renderer, debug);
+
+  const bool isRightAligned =
+      band.submitted.options.direction == HB_DIRECTION_RTL;
+  float y = bound.h - 2 * BAND_PADDING - SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE -
+            result.ascend;
+
+  for (const auto &paragraph : result.paragraphs) {
+    for (const auto &line : paragraph.lines) {
+      if (y + result.ascend < 0)
+        return;
+
+      float x = isRightAligned ? bound.w - BAND_PADDING -
+                                     HBPosToFloat(line.advance)
+                               : BAND_PADDING;
+
+      // Glyphs still being rasterized are filled in on a later frame.
+      DrawAtlasLine(renderer, overlay, atlas, band.id, result.generation,
+                    line, color, x, y);
+
+      y -= result.lineHeight;
+    }
+  }
+}
+} // namespace
+
+void RenderModeTick(
+    SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
+    const magic_enum::containers::array<VariationAxis, float> &axisValues,
+    std::u16string_view text, const int &fontSize, const LayoutOptions &options,
+    const SDL_Color &color) {
+  if (!font.IsValid())
+    return;
+
+  // The first time the view is shown.
+  if (bands.empty() && nextBandId == 1) {
+    AddDefaultBands();
+  }
+
+  if (font.Data() != fontData) {
+    ResetWorkers(font);
+  }
+
+  if (atlas.PageCount() > MAX_ATLAS_PAGES) {
+    atlas.Clear();
+    for (auto &band : bands) {
+      band.isAtlasStale = true;
+    }
+  }
+
+  const auto visibleCount = std::ranges::count_if(
+      bands, [](const Band &band) { return band.isVisible; });
+  if (visibleCount == 0)
+    return;
+
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+  const int bandHeight = bound.h / static_cast<int>(visibleCount);
+
+  // Bands only lay out horizontally.
+  LayoutOptions bandOptions = options;
+  if (bandOptions.direction == HB_DIRECTION_TTB) {
+    bandOptions.direction = HB_DIRECTION_LTR;
+  }
+
+  int top = 0;
+  for (auto &band : bands) {
+    CollectResult(renderer, band);
+
+    // Hidden bands keep their glyphs in the atlas but are not laid out.
+    if (!band.isVisible)
+      continue;
+
+    Submit(band, {
+                     .fontSize = fontSize,
+                     .renderMode = band.mode,
+                     .isAxisValuesSet = true,
+                     .axisValues = axisValues,
+                     .text = std::u16string(text),
+                     .options = bandOptions,
+                     .extent = FloatToHBPos(bound.w - 2 * BAND_PADDING),
+                 });
+
+    SDL_Rect viewport{bound.x, bound.y + top, bound.w, bandHeight};
+    SDL_SetRenderViewport(renderer, &viewport);
+
+    DrawBand(renderer, debug, band, color);
+
+    top += bandHeight;
+  }
+
+  SDL_SetRenderViewport(renderer, &bound);
+}
+
+bool RenderModeEdit(RenderMode &mode) {
+  bool isChanged = false;
+
+  if (ImGui::BeginCombo("Hinting",
+                        magic_enum::enum_name(mode.hinting).data())) {
+    magic_enum::enum_for_each<Hinting>([&mode, &isChanged](const Hinting &h) {
+      if (ImGui::Selectable(magic_enum::enum_name(h).data(),
+                            mode.hinting == h)) {
+        isChanged |= mode.hinting != h;
+        mode.hinting = h;
+      }
+    });
+    ImGui::EndCombo();
+  }
+
+  if (ImGui::BeginCombo("Autohinter",
+                        magic_enum::enum_name(mode.autohinter).data())) {
+    magic_enum::enum_for_each<Autohinter>(
+        [&mode, &isChanged](const Autohinter &a) {
+          if (ImGui::Selectable(magic_enum::enum_name(a).data(),
+                                mode.autohinter == a)) {
+            isChanged |= mode.autohinter != a;
+            mode.autohinter = a;
+          }
+        });
+    ImGui::EndCombo();
+  }
+
+  isChanged |= ImGui::SliderFloat("Gamma", &mode.gamma, 0.5f, 3.0f, "%.2f");
+
+  return isChanged;
+}
+
+void RenderModeDoUI() {
+  if (ImGui::Begin("Render modes")) {
+    if (ImGui::Button("Add mode##render modes")) {
+      AddBand({});
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset##render modes")) {
+      RenderModeCleanUp();
+      AddDefaultBands();
+    }
+
+    size_t pending = 0;
+    std::chrono::duration<double> totalElapsed{};
+    for (const auto &band : bands) {
+      pending += IsJobRunning(band) ? 1 : 0;
+      totalElapsed += band.result.elapsed;
+    }
+
+    ImGui::LabelText("Pending jobs", "%zu", pending);
+    ImGui::LabelText("Job time (total)", "%.1f ms",
+                     totalElapsed.count() * 1000.0);
+    ImGui::LabelText("Atlas", "%zu glyphs, %zu pages", atlas.GlyphCount(),
+                     atlas.PageCount());
+
+    std::optional<size_t> removed;
+
+    for (size_t i = 0; i < bands.size(); i++) {
+      auto &band = bands[i];
+      ImGui::PushID(static_cast<int>(band.id));
+
+      ImGui::SeparatorText(band.mode.Name().c_str());
+      ImGui::Checkbox("Show", &band.isVisible);
+      RenderModeEdit(band.mode);
+
+      ImGui::LabelText("Job time", "%.1f ms",
+                       band.result.elapsed.count() * 1000.0);
+
+      if (ImGui::Button("Remove")) {
+        removed = i;
+      }
+
+      ImGui::PopID();
+    }
+
+    if (removed.has_value()) {
+      RetireJob(bands[*removed]);
+      bands.erase(bands.begin() + *removed);
+    }
+  }
+  ImGui::End();
+}
+
+void RenderModeCleanUp() {
+  for (auto &band : bands) {
+    if (IsJobRunning(band)) {
+      band.job.wait();
+    }
+  }
+  for (auto &job : retiredJobs) {
+    job.wait();
+  }
+
+  retiredJobs.clear();
+  bands.clear();
+  fontData.reset();
+  atlas.Clear();
+}
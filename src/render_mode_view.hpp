@@ -0,0 +1,30 @@
+#ifndef RENDER_MODE_VIEW_HPP
+#define RENDER_MODE_VIEW_HPP
+
+#include "debug_settings.hpp"
+#include "font.hpp"
+#include "text_layout.hpp"
+#include <SDL3/SDL.h>
+#include <magic_enum/magic_enum_containers.hpp>
+#include <string_view>
+
+/*
+ * Renders the text with several render modes of the same font, one band per
+ * mode. Every mode has its own worker font and atlas namespace, so the modes
+ * are rasterized in parallel and a mode that was hidden and shown again does
+ * not rasterize anything.
+ */
+void RenderModeTick(
+    SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
+    const magic_enum::containers::array<VariationAxis, float> &axisValues,
+    std::u16string_view text, const int &fontSize, const LayoutOptions &options,
+    const SDL_Color &color);
+
+void RenderModeDoUI();
+
+// Edits `mode`, returns true when it changed.
+bool RenderModeEdit(RenderMode &mode);
+
+void RenderModeCleanUp();
+
+#endif
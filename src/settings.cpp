@@ -13,6 +13,11 @@ void SaveSettings(const Settings &settings) {
   json js{};
 
   js["font_path"] = settings.fontPath;
+  js["glyph_cache_enabled"] = settings.isGlyphCacheEnabled;
+  js["glyph_cache_max_size"] = settings.glyphCacheMaxSize;
+  js["shape_cache_enabled"] = settings.isShapeCacheEnabled;
+  js["shape_cache_max_size"] = settings.shapeCacheMaxSize;
+  js["max_fps"] = settings.maxFps;
 
   std::string str = js.dump();
 
@@ -48,6 +53,15 @@ Settings LoadSettings() {
   try {
     Settings output{};
     output.fontPath = std::string(js["font_path"]);
+    output.isGlyphCacheEnabled =
+        js.value("glyph_cache_enabled", output.isGlyphCacheEnabled);
+    output.glyphCacheMaxSize =
+        js.value("glyph_cache_max_size", output.glyphCacheMaxSize);
+    output.isShapeCacheEnabled =
+        js.value("shape_cache_enabled", output.isShapeCacheEnabled);
+    output.shapeCacheMaxSize =
+        js.value("shape_cache_max_size", output.shapeCacheMaxSize);
+    output.maxFps = js.value("max_fps", output.maxFps);
 
     return output;
   } catch (const json::exception &e) {
@@ -1,10 +1,19 @@
 #ifndef SETTINGS_HPP
 #define SETTINGS_HPP
 
+#include <cstddef>
 #include <filesystem>
 
 struct Settings {
   std::filesystem::path fontPath{std::filesystem::absolute("fonts").string()};
+
+  bool isGlyphCacheEnabled{true};
+  size_t glyphCacheMaxSize{256 * 1024 * 1024};
+
+  bool isShapeCacheEnabled{true};
+  size_t shapeCacheMaxSize{64 * 1024 * 1024};
+
+  int maxFps{60};
 };
 
 void SaveSettings(const Settings &settings);
@@ -0,0 +1,55 @@
+#include "shape_disk_cache.hpp"
+
+#include <cstring>
+
+namespace {
+constexpr RecordFile::Magic FILE_MAGIC{'F', 'R', 'T', 'S', 'H', 'A', 'P', 'E'};
+constexpr uint32_t FILE_VERSION = 1;
+
+// Followed by the glyphs.
+struct RunRecord {
+  int32_t xAdvance;
+  int32_t yAdvance;
+};
+
+static_assert(std::has_unique_object_representations_v<ShapedGlyph>);
+} // namespace
+
+ShapeDiskCache::ShapeDiskCache() : file(FILE_MAGIC, FILE_VERSION) {}
+
+std::optional<ShapedRun> ShapeDiskCache::Find(const ShapeCacheKey &key) {
+  auto payload = file.Find(AsBytes(key));
+  if (!payload.has_value() || payload->size() < sizeof(RunRecord) ||
+      (payload->size() - sizeof(RunRecord)) % sizeof(ShapedGlyph) != 0)
+    return std::nullopt;
+
+  RunRecord record;
+  std::memcpy(&record, payload->data(), sizeof(record));
+
+  ShapedRun run{
+      .xAdvance = record.xAdvance,
+      .yAdvance = record.yAdvance,
+  };
+
+  run.glyphs.resize((payload->size() - sizeof(RunRecord)) /
+                    sizeof(ShapedGlyph));
+  std::memcpy(run.glyphs.data(), payload->data() + sizeof(RunRecord),
+              run.glyphs.size() * sizeof(ShapedGlyph));
+
+  return run;
+}
+
+void ShapeDiskCache::Insert(const ShapeCacheKey &key, const ShapedRun &run) {
+  const RunRecord record{
+      .xAdvance = run.xAdvance,
+      .yAdvance = run.yAdvance,
+  };
+
+  const auto glyphSize = run.glyphs.size() * sizeof(ShapedGlyph);
+
+  std::vector<uint8_t> payload(sizeof(record) + glyphSize);
+  std::memcpy(payload.data(), &record, sizeof(record));
+  std::memcpy(payload.data() + sizeof(record), run.glyphs.data(), glyphSize);
+
+  file.Insert(AsBytes(key), payload);
+}
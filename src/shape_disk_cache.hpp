@@ -0,0 +1,56 @@
+#ifndef SHAPE_DISK_CACHE_HPP
+#define SHAPE_DISK_CACHE_HPP
+
+#include "record_file.hpp"
+#include "shaper.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+struct ShapeCacheKey {
+  // Hash of the font file content.
+  uint64_t font{0};
+
+  // Hash of the variation axis values, 0 for the default instance.
+  uint64_t variation{0};
+
+  // Hashes of the UTF-16 text of the run, its language tag and the enabled
+  // OpenType features (0 when there are none).
+  uint64_t text{0};
+  uint64_t language{0};
+  uint64_t features{0};
+
+  uint32_t size{0};
+  uint32_t script{0};
+  uint32_t direction{0};
+  uint32_t reserved{0};
+
+  bool operator==(const ShapeCacheKey &) const = default;
+};
+
+// HarfBuzz shaping results kept on disk between sessions.
+class ShapeDiskCache {
+public:
+  ShapeDiskCache();
+
+  bool Open(const std::filesystem::path &path, const size_t &maxSize) {
+    return file.Open(path, maxSize);
+  }
+  void Close() { file.Close(); }
+  bool IsOpen() const { return file.IsOpen(); }
+
+  std::optional<ShapedRun> Find(const ShapeCacheKey &key);
+  void Insert(const ShapeCacheKey &key, const ShapedRun &run);
+
+  void Clear() { file.Clear(); }
+
+  size_t FileSize() const { return file.FileSize(); }
+  size_t RecordCount() const { return file.RecordCount(); }
+  size_t HitCount() const { return file.HitCount(); }
+  size_t MissCount() const { return file.MissCount(); }
+
+private:
+  RecordFile file;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "shaper.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+// Past this many runs the cache is dropped and refilled from the visible text.
+constexpr size_t MAX_SHAPE_CACHE_ENTRIES = 8192;
+
+void HashCombine(size_t &seed, const size_t &value) {
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+hb_buffer_t *ThreadBuffer() {
+  thread_local std::unique_ptr<hb_buffer_t, decltype(&hb_buffer_destroy)>
+      buffer(hb_buffer_create(), &hb_buffer_destroy);
+
+  hb_buffer_reset(buffer.get());
+  return buffer.get();
+}
+
+std::vector<hb_feature_t> ToHbFeatures(const FeatureSettings &features) {
+  std::vector<hb_feature_t> output;
+  output.reserve(features.size());
+
+  for (const auto &feature : features) {
+    output.push_back({
+        .tag = feature.tag,
+        .value = feature.value,
+        .start = feature.start,
+        .end = feature.end,
+    });
+  }
+
+  return output;
+}
+} // namespace
+
+FeatureSettings ClipFeatures(const FeatureSettings &features,
+                             const size_t &offset, const size_t &length) {
+  FeatureSettings output;
+
+  for (const auto &feature : features) {
+    if (feature.IsGlobal()) {
+      output.push_back(feature);
+      continue;
+    }
+
+    const size_t start = std::max<size_t>(feature.start, offset);
+    const size_t end = std::min<size_t>(feature.end, offset + length);
+    if (start >= end)
+      continue;
+
+    output.push_back({
+        .tag = feature.tag,
+        .value = feature.value,
+        .start = static_cast<uint32_t>(start - offset),
+        .end = static_cast<uint32_t>(end - offset),
+    });
+  }
+
+  return output;
+}
+
+hb_shape_plan_t *
+ShapePlanCache::Get(hb_font_t *font, const hb_segment_properties_t &props,
+                    const std::vector<hb_feature_t> &features) {
+  Key key{props.direction, props.script, props.language, {}};
+  for (const auto &feature : features) {
+    std::get<3>(key).emplace_back(feature.tag, feature.value,
+                                  feature.start == HB_FEATURE_GLOBAL_START &&
+                                      feature.end == HB_FEATURE_GLOBAL_END);
+  }
+
+  std::scoped_lock lock(mutex);
+
+  auto iter = plans.find(key);
+  if (iter != plans.end())
+    return iter->second;
+
+  unsigned int coordCount = 0;
+  const int *coords = hb_font_get_var_coords_normalized(font, &coordCount);
+
+  auto plan = hb_shape_plan_create2(
+      hb_font_get_face(font), &props, features.data(),
+      static_cast<unsigned int>(features.size()), coords, coordCount, nullptr);
+  plans.emplace(std::move(key), plan);
+
+  return plan;
+}
+
+void ShapePlanCache::Clear() {
+  std::scoped_lock lock(mutex);
+
+  for (auto &[key, plan] : plans) {
+    hb_shape_plan_destroy(plan);
+  }
+  plans.clear();
+}
+
+ShapedRun ShapeText(hb_font_t *font, std::u16string_view text,
+                    const hb_script_t &script, const hb_direction_t &direction,
+                    const hb_language_t &language,
+                    const FeatureSettings &features, ShapePlanCache *plans) {
+  hb_buffer_t *buffer = ThreadBuffer();
+  hb_buffer_set_direction(buffer, direction);
+  hb_buffer_set_script(buffer, script);
+
+  if (language != HB_LANGUAGE_INVALID)
+    hb_buffer_set_language(buffer, language);
+
+  hb_buffer_add_utf16(buffer, reinterpret_cast<const uint16_t *>(text.data()),
+                      text.size(), 0, text.size());
+
+  const auto hbFeatures = ToHbFeatures(features);
+
+  if (plans != nullptr) {
+    // The plan must be made for the properties the buffer ended up with.
+    hb_segment_properties_t props;
+    hb_buffer_get_segment_properties(buffer, &props);
+
+    hb_shape_plan_execute(plans->Get(font, props, hbFeatures), font, buffer,
+                          hbFeatures.data(),
+                          static_cast<unsigned int>(hbFeatures.size()));
+  } else {
+    hb_shape(font, buffer, hbFeatures.data(),
+             static_cast<unsigned int>(hbFeatures.size()));
+  }
+
+  unsigned int glyph_count = hb_buffer_get_length(buffer);
+  hb_glyph_info_t *glyph_infos = hb_buffer_get_glyph_infos(buffer, NULL);
+  hb_glyph_position_t *glyph_positions =
+      hb_buffer_get_glyph_positions(buffer, NULL);
+
+  ShapedRun output;
+  output.glyphs.reserve(glyph_count);
+
+  for (unsigned int i = 0; i < glyph_count; i++) {
+    output.glyphs.push_back({
+        .index = glyph_infos[i].codepoint,
+        .cluster = glyph_infos[i].cluster,
+        .xAdvance = glyph_positions[i].x_advance,
+        .yAdvance = glyph_positions[i].y_advance,
+        .xOffset = glyph_positions[i].x_offset,
+        .yOffset = glyph_positions[i].y_offset,
+    });
+
+    output.xAdvance += glyph_positions[i].x_advance;
+    output.yAdvance += glyph_positions[i].y_advance;
+  }
+
+  return output;
+}
+
+ShapedRunPtr ShapeCache::Find(std::u16string_view text,
+                              const hb_script_t &script,
+                              const hb_direction_t &direction,
+                              const hb_language_t &language,
+                              const FeatureSettings &features) const {
+  auto iter = entries.find(
+      Key{std::u16string(text), script, direction, language, features});
+  if (iter == entries.end()) {
+    return nullptr;
+  }
+
+  return iter->second;
+}
+
+ShapedRunPtr ShapeCache::Insert(std::u16string_view text,
+                                const hb_script_t &script,
+                                const hb_direction_t &direction,
+                                const hb_language_t &language,
+                                const FeatureSettings &features,
+                                ShapedRun run) {
+  if (entries.size() >= MAX_SHAPE_CACHE_ENTRIES) {
+    entries.clear();
+  }
+
+  auto shared = std::make_shared<const ShapedRun>(std::move(run));
+  entries.insert_or_assign(
+      Key{std::u16string(text), script, direction, language, features},
+      shared);
+
+  return shared;
+}
+
+size_t ShapeCache::KeyHash::operator()(const Key &key) const {
+  size_t seed = std::hash<std::u16string>{}(key.text);
+  HashCombine(seed, std::hash<uint32_t>{}(key.script));
+  HashCombine(seed, std::hash<uint32_t>{}(key.direction));
+  HashCombine(seed, std::hash<const void *>{}(key.language));
+
+  for (const auto &feature : key.features) {
+    HashCombine(seed, std::hash<uint32_t>{}(feature.tag));
+    HashCombine(seed, std::hash<uint32_t>{}(feature.value));
+    HashCombine(seed, std::hash<uint32_t>{}(feature.start));
+    HashCombine(seed, std::hash<uint32_t>{}(feature.end));
+  }
+
+  return seed;
+}
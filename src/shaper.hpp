@@ -0,0 +1,136 @@
+#ifndef SHAPER_HPP
+#define SHAPER_HPP
+
+#include <harfbuzz/hb.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+struct ShapedGlyph {
+  hb_codepoint_t index{0};
+
+  // UTF-16 offset of the glyph's cluster, relative to the start of the run.
+  uint32_t cluster{0};
+
+  hb_position_t xAdvance{0};
+  hb_position_t yAdvance{0};
+  hb_position_t xOffset{0};
+  hb_position_t yOffset{0};
+};
+
+struct ShapedRun {
+  std::vector<ShapedGlyph> glyphs;
+
+  hb_position_t xAdvance{0};
+  hb_position_t yAdvance{0};
+};
+
+using ShapedRunPtr = std::shared_ptr<const ShapedRun>;
+
+// An OpenType feature turned on or off, with the same meaning as
+// hb_feature_t. The range is in UTF-16 offsets of the paragraph; the default
+// one covers all of it.
+struct FeatureSetting {
+  hb_tag_t tag{0};
+  uint32_t value{1};
+  uint32_t start{HB_FEATURE_GLOBAL_START};
+  uint32_t end{HB_FEATURE_GLOBAL_END};
+
+  bool IsGlobal() const {
+    return start == HB_FEATURE_GLOBAL_START && end == HB_FEATURE_GLOBAL_END;
+  }
+
+  bool operator==(const FeatureSetting &) const = default;
+};
+
+using FeatureSettings = std::vector<FeatureSetting>;
+
+// The settings that apply to the run at `offset`, with their ranges made
+// relative to it. Ranged settings outside of the run are left out.
+FeatureSettings ClipFeatures(const FeatureSettings &features,
+                             const size_t &offset, const size_t &length);
+
+/*
+ * Keeps one HarfBuzz shape plan per segment properties and feature set.
+ * HarfBuzz caches plans on the face too, but not the ones with ranged
+ * features, and looking them up there takes a lock.
+ *
+ * Plans depend on the variation of the font, so the cache must be cleared
+ * when it changes. Plans can be looked up and executed from several threads.
+ */
+class ShapePlanCache {
+public:
+  ShapePlanCache() = default;
+  ShapePlanCache(const ShapePlanCache &) = delete;
+  ShapePlanCache &operator=(const ShapePlanCache &) = delete;
+  ~ShapePlanCache() { Clear(); }
+
+  hb_shape_plan_t *Get(hb_font_t *font, const hb_segment_properties_t &props,
+                       const std::vector<hb_feature_t> &features);
+
+  void Clear();
+
+private:
+  // Ranges are only used when a plan is executed, the plan itself only
+  // depends on whether a feature is global.
+  using Key = std::tuple<hb_direction_t, hb_script_t, hb_language_t,
+                         std::vector<std::tuple<hb_tag_t, uint32_t, bool>>>;
+
+  std::mutex mutex;
+  std::map<Key, hb_shape_plan_t *> plans;
+};
+
+// Uses the plan from `plans` when given, otherwise lets HarfBuzz pick one.
+// Each thread reuses its own buffer.
+ShapedRun ShapeText(hb_font_t *font, std::u16string_view text,
+                    const hb_script_t &script, const hb_direction_t &direction,
+                    const hb_language_t &language,
+                    const FeatureSettings &features = {},
+                    ShapePlanCache *plans = nullptr);
+
+/*
+ * Keeps the shaping result of every run seen since the font last changed, so
+ * only runs whose text (or properties) changed need to go through HarfBuzz.
+ * Results of every feature set are kept side by side, so toggling a feature
+ * back finds the runs shaped before.
+ */
+class ShapeCache {
+public:
+  // Returns null when the run has not been shaped yet.
+  ShapedRunPtr Find(std::u16string_view text, const hb_script_t &script,
+                    const hb_direction_t &direction,
+                    const hb_language_t &language,
+                    const FeatureSettings &features) const;
+
+  ShapedRunPtr Insert(std::u16string_view text, const hb_script_t &script,
+                      const hb_direction_t &direction,
+                      const hb_language_t &language,
+                      const FeatureSettings &features, ShapedRun run);
+
+  void Clear() { entries.clear(); }
+  size_t Size() const { return entries.size(); }
+
+private:
+  struct Key {
+    std::u16string text;
+    hb_script_t script;
+    hb_direction_t direction;
+    hb_language_t language;
+    FeatureSettings features;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  std::unordered_map<Key, ShapedRunPtr, KeyHash> entries;
+};
+
+#endif
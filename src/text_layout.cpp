@@ -0,0 +1,380 @@
+#include "text_layout.hpp"
+
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <spdlog/spdlog.h>
+#include <unicode/uchar.h>
+
+namespace {
+// Below this many runs to shape, waking the workers up costs more than it
+// saves.
+constexpr size_t PARALLEL_SHAPING_MIN_RUNS = 32;
+
+bool IsValidFor(const LayoutParagraph &paragraph, const hb_position_t &extent) {
+  if (extent < paragraph.validMin)
+    return false;
+
+  return paragraph.validMax == TextLayout::NO_WRAP ||
+         extent < paragraph.validMax;
+}
+
+std::pmr::vector<std::u16string_view>
+SplitParagraphs(std::u16string_view text, std::pmr::memory_resource *scratch) {
+  std::pmr::vector<std::u16string_view> output(scratch);
+
+  while (true) {
+    auto lineEnd = text.find(u'\n');
+    output.push_back(text.substr(0, lineEnd));
+
+    if (lineEnd == std::u16string_view::npos)
+      break;
+
+    text.remove_prefix(lineEnd + 1);
+  }
+
+  return output;
+}
+} // namespace
+
+TextLayout::~TextLayout() {
+  if (breakIterator != nullptr) {
+    ubrk_close(breakIterator);
+  }
+}
+
+void TextLayout::Update(Font &font, std::u16string_view text,
+                        const LayoutOptions &newOptions,
+                        const hb_position_t &newExtent,
+                        std::pmr::memory_resource *scratch) {
+  // Features do not change the runs nor the line breaks.
+  LayoutOptions withFeatures = options;
+  withFeatures.features = newOptions.features;
+
+  const bool isInvalidated =
+      newOptions != withFeatures || font.Generation() != fontGeneration;
+  const bool isReshaped = newOptions.features != options.features;
+
+  options = newOptions;
+  fontGeneration = font.Generation();
+  extent = newExtent;
+
+  const auto texts = SplitParagraphs(text, scratch);
+
+  // Paragraphs at both ends that did not change are kept as they are, which
+  // covers the usual single edit in the text editor.
+  size_t prefix = 0;
+  size_t suffix = 0;
+
+  if (!isInvalidated) {
+    while (prefix < texts.size() && prefix < paragraphs.size() &&
+           paragraphs[prefix].text == texts[prefix]) {
+      prefix++;
+    }
+
+    while (suffix < texts.size() - prefix &&
+           suffix < paragraphs.size() - prefix &&
+           paragraphs[paragraphs.size() - suffix - 1].text ==
+               texts[texts.size() - suffix - 1]) {
+      suffix++;
+    }
+  }
+
+  std::vector<LayoutParagraph> updated;
+  updated.reserve(texts.size());
+
+  // Indices of the paragraphs to shape, new or with other features.
+  std::pmr::vector<size_t> unshaped(scratch);
+
+  std::move(paragraphs.begin(), paragraphs.begin() + prefix,
+            std::back_inserter(updated));
+
+  if (isReshaped) {
+    for (size_t i = 0; i < prefix; i++) {
+      unshaped.push_back(i);
+    }
+  }
+
+  for (size_t i = prefix; i < texts.size() - suffix; i++) {
+    LayoutParagraph paragraph{.text = std::u16string(texts[i])};
+
+    Itemize(paragraph);
+    FindBreaks(paragraph);
+
+    unshaped.push_back(updated.size());
+    updated.push_back(std::move(paragraph));
+  }
+
+  std::move(paragraphs.end() - suffix, paragraphs.end(),
+            std::back_inserter(updated));
+
+  if (isReshaped) {
+    for (size_t i = updated.size() - suffix; i < updated.size(); i++) {
+      unshaped.push_back(i);
+    }
+  }
+
+  paragraphs = std::move(updated);
+  ShapeParagraphs(font, unshaped, scratch);
+
+  // New paragraphs have an empty valid range, so they are wrapped here too.
+  for (auto &paragraph : paragraphs) {
+    if (!IsValidFor(paragraph, extent)) {
+      Wrap(paragraph);
+    }
+  }
+}
+
+void TextLayout::Itemize(LayoutParagraph &paragraph) const {
+  paragraph.runs = ItemizeParagraph(paragraph.text, options.direction,
+                                    options.script, options.language);
+}
+
+/*
+ * Runs missing from the font caches are shaped on the thread pool when there
+ * are enough of them, each task with its own HarfBuzz buffer. The results are
+ * added to the caches in paragraph and run order, so the outcome does not
+ * depend on which task finished first.
+ */
+void TextLayout::ShapeParagraphs(Font &font,
+                                 const std::pmr::vector<size_t> &indices,
+                                 std::pmr::memory_resource *scratch) {
+  struct PendingRun {
+    size_t paragraph{0};
+    size_t run{0};
+    ShapedRun shaped;
+  };
+
+  std::pmr::vector<PendingRun> pending(scratch);
+
+  for (const auto &p : indices) {
+    auto &paragraph = paragraphs[p];
+    paragraph.shapedRuns.assign(paragraph.runs.size(), nullptr);
+
+    for (size_t r = 0; r < paragraph.runs.size(); r++) {
+      paragraph.shapedRuns[r] =
+          font.FindShaped(paragraph.text, paragraph.runs[r], options.features);
+
+      if (!paragraph.shapedRuns[r]) {
+        pending.push_back({.paragraph = p, .run = r});
+      }
+    }
+  }
+
+  auto shape = [this, &font, &pending](const size_t &i) {
+    auto &item = pending[i];
+    const auto &paragraph = paragraphs[item.paragraph];
+    item.shaped = font.ShapeUncached(paragraph.text, paragraph.runs[item.run],
+                                     options.features);
+  };
+
+  if (pending.size() >= PARALLEL_SHAPING_MIN_RUNS) {
+    ThreadPool::Shared().ForEach(pending.size(), shape);
+  } else {
+    for (size_t i = 0; i < pending.size(); i++) {
+      shape(i);
+    }
+  }
+
+  for (auto &item : pending) {
+    auto &paragraph = paragraphs[item.paragraph];
+    paragraph.shapedRuns[item.run] =
+        font.AddShaped(paragraph.text, paragraph.runs[item.run],
+                       options.features, std::move(item.shaped));
+  }
+
+  for (const auto &p : indices) {
+    Measure(paragraphs[p]);
+  }
+}
+
+// The advances change with the shaping, so the lines are invalidated too.
+void TextLayout::Measure(LayoutParagraph &paragraph) const {
+  paragraph.lines.clear();
+  paragraph.validMin = 0;
+  paragraph.validMax = 0;
+  paragraph.advances.assign(paragraph.text.size() + 1, 0);
+
+  const bool isVertical = HB_DIRECTION_IS_VERTICAL(options.direction);
+
+  for (size_t r = 0; r < paragraph.runs.size(); r++) {
+    const auto &run = paragraph.runs[r];
+
+    for (const auto &glyph : paragraph.shapedRuns[r]->glyphs) {
+      paragraph.advances[run.offset + glyph.cluster + 1] +=
+          isVertical ? -glyph.yAdvance : glyph.xAdvance;
+    }
+  }
+
+  std::partial_sum(paragraph.advances.begin(), paragraph.advances.end(),
+                   paragraph.advances.begin());
+}
+
+void TextLayout::FindBreaks(LayoutParagraph &paragraph) {
+  paragraph.breaks.clear();
+
+  if (paragraph.text.empty())
+    return;
+
+  UErrorCode error = U_ZERO_ERROR;
+
+  if (breakIterator == nullptr || breakLocale != options.language) {
+    if (breakIterator != nullptr) {
+      ubrk_close(breakIterator);
+    }
+
+    // ICU uses a dictionary for scripts without spaces (Thai, Lao, Khmer...)
+    // regardless of the locale.
+    breakIterator =
+        ubrk_open(UBRK_LINE, options.language.c_str(), nullptr, 0, &error);
+    breakLocale = options.language;
+  }
+
+  if (breakIterator != nullptr) {
+    ubrk_setText(breakIterator,
+                 reinterpret_cast<const UChar *>(paragraph.text.data()),
+                 static_cast<int32_t>(paragraph.text.size()), &error);
+  }
+
+  if (breakIterator == nullptr || U_FAILURE(error)) {
+    spdlog::error("Unable to find line breaks: {}", u_errorName(error));
+    paragraph.breaks.push_back(paragraph.text.size());
+
+    return;
+  }
+
+  for (auto position = ubrk_following(breakIterator, 0); position != UBRK_DONE;
+       position = ubrk_next(breakIterator)) {
+    paragraph.breaks.push_back(static_cast<size_t>(position));
+  }
+}
+
+/*
+ * Greedy line filling over the break opportunities, measured from the shaped
+ * advances, so no candidate line is ever reshaped. A word wider than the
+ * extent is put on a line by itself.
+ *
+ * While wrapping, record the extents for which the result stays the same:
+ * every line that fits must still fit, and no line may be able to take the
+ * next word.
+ */
+void TextLayout::Wrap(LayoutParagraph &paragraph) const {
+  const auto &text = paragraph.text;
+  const auto &breaks = paragraph.breaks;
+
+  auto width = [&paragraph](const size_t &start, const size_t &end) {
+    return paragraph.advances[end] - paragraph.advances[start];
+  };
+
+  auto trimmed = [&text](const size_t &start, size_t end) {
+    while (end > start && u_isUWhiteSpace(text[end - 1])) {
+      end--;
+    }
+    return end;
+  };
+
+  paragraph.lines.clear();
+  paragraph.validMin = 0;
+  paragraph.validMax = NO_WRAP;
+
+  if (breaks.empty()) {
+    paragraph.lines.push_back(CreateLine(paragraph, 0, 0));
+    return;
+  }
+
+  size_t lineStart = 0;
+  size_t i = 0;
+
+  while (i < breaks.size()) {
+    size_t last = i;
+    const bool isForced =
+        width(lineStart, trimmed(lineStart, breaks[i])) > extent;
+
+    if (!isForced) {
+      while (last + 1 < breaks.size() &&
+             width(lineStart, trimmed(lineStart, breaks[last + 1])) <=
+                 extent) {
+        last++;
+      }
+    }
+
+    const size_t lineEnd = trimmed(lineStart, breaks[last]);
+
+    if (!isForced) {
+      paragraph.validMin =
+          std::max(paragraph.validMin, width(lineStart, lineEnd));
+    }
+
+    if (last + 1 < breaks.size()) {
+      paragraph.validMax =
+          std::min(paragraph.validMax,
+                   width(lineStart, trimmed(lineStart, breaks[last + 1])));
+    }
+
+    paragraph.lines.push_back(CreateLine(paragraph, lineStart, lineEnd));
+
+    lineStart = breaks[last];
+    i = last + 1;
+  }
+}
+
+LayoutLine TextLayout::CreateLine(const LayoutParagraph &paragraph,
+                                  const size_t &start,
+                                  const size_t &end) const {
+  LayoutLine line{
+      .start = start,
+      .end = end,
+      .advance = paragraph.advances[end] - paragraph.advances[start],
+  };
+
+  std::vector<uint8_t> levels;
+
+  for (size_t r = 0; r < paragraph.runs.size(); r++) {
+    const auto &run = paragraph.runs[r];
+    const auto &shaped = paragraph.shapedRuns[r];
+
+    const size_t runStart = std::max(start, run.offset);
+    const size_t runEnd = std::min(end, run.offset + run.length);
+    if (runStart >= runEnd)
+      continue;
+
+    // Glyph clusters are monotonic within a run (descending for RTL), so the
+    // glyphs belonging to the line are a contiguous range.
+    size_t glyphStart = shaped->glyphs.size();
+    size_t glyphEnd = 0;
+
+    for (size_t g = 0; g < shaped->glyphs.size(); g++) {
+      const size_t cluster = run.offset + shaped->glyphs[g].cluster;
+      if (cluster >= runStart && cluster < runEnd) {
+        glyphStart = std::min(glyphStart, g);
+        glyphEnd = g + 1;
+      }
+    }
+
+    if (glyphStart >= glyphEnd)
+      continue;
+
+    line.runs.push_back({
+        .shaped = shaped,
+        .glyphStart = glyphStart,
+        .glyphEnd = glyphEnd,
+        .offset = run.offset,
+        .level = run.level,
+    });
+    levels.push_back(run.level);
+  }
+
+  if (line.runs.size() > 1) {
+    std::vector<LineRun> reordered;
+    reordered.reserve(line.runs.size());
+
+    for (const auto &logicalIndex : VisualRunOrder(levels)) {
+      reordered.push_back(line.runs[logicalIndex]);
+    }
+
+    line.runs = std::move(reordered);
+  }
+
+  return line;
+}
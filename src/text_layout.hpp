@@ -0,0 +1,116 @@
+#ifndef TEXT_LAYOUT_HPP
+#define TEXT_LAYOUT_HPP
+
+#include "font.hpp"
+#include "itemizer.hpp"
+#include "shaper.hpp"
+#include <harfbuzz/hb.h>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unicode/ubrk.h>
+#include <vector>
+
+struct LayoutOptions {
+  hb_direction_t direction{HB_DIRECTION_LTR};
+  hb_script_t script{HB_SCRIPT_INVALID};
+  std::string language{};
+
+  // Relative to each paragraph.
+  FeatureSettings features{};
+
+  bool operator==(const LayoutOptions &) const = default;
+};
+
+// The part of a shaped run that is placed on one line.
+struct LineRun {
+  ShapedRunPtr shaped;
+  size_t glyphStart{0};
+  size_t glyphEnd{0};
+
+  // Paragraph offset of the shaped run, add it to a glyph cluster to get the
+  // paragraph offset of the glyph.
+  size_t offset{0};
+  uint8_t level{0};
+};
+
+struct LayoutLine {
+  // UTF-16 range within the paragraph, trailing whitespace excluded.
+  size_t start{0};
+  size_t end{0};
+
+  hb_position_t advance{0};
+
+  // In visual order.
+  std::vector<LineRun> runs;
+};
+
+struct LayoutParagraph {
+  std::u16string text;
+
+  std::vector<TextRun> runs;
+  std::vector<ShapedRunPtr> shapedRuns;
+
+  // Prefix sums of the shaped advances, indexed by UTF-16 offset. A cluster's
+  // advance is accounted to its first code unit.
+  std::vector<hb_position_t> advances;
+
+  // Offsets where a line is allowed to end, in ascending order.
+  std::vector<size_t> breaks;
+
+  std::vector<LayoutLine> lines;
+
+  // The wrap extent range for which `lines` stays the same.
+  hb_position_t validMin{0};
+  hb_position_t validMax{0};
+};
+
+/*
+ * Keeps the itemized, shaped and wrapped paragraphs of the text between
+ * frames. `Update()` only redoes what has been invalidated: paragraphs whose
+ * text is unchanged are reused on edit, and on resize only paragraphs whose
+ * line breaks would actually move are wrapped again. Changing the features
+ * keeps the runs and line breaks, only the shaping is redone, spread over the
+ * thread pool when many runs are not cached.
+ */
+class TextLayout {
+public:
+  static constexpr hb_position_t NO_WRAP =
+      std::numeric_limits<hb_position_t>::max();
+
+  TextLayout() = default;
+  TextLayout(const TextLayout &) = delete;
+  TextLayout &operator=(const TextLayout &) = delete;
+  ~TextLayout();
+
+  // Temporary data is allocated from `scratch`, which only has to outlive
+  // the call.
+  void Update(Font &font, std::u16string_view text,
+              const LayoutOptions &options, const hb_position_t &extent,
+              std::pmr::memory_resource *scratch =
+                  std::pmr::get_default_resource());
+
+  const std::vector<LayoutParagraph> &Paragraphs() const { return paragraphs; }
+  const LayoutOptions &Options() const { return options; }
+
+private:
+  void Itemize(LayoutParagraph &paragraph) const;
+  void ShapeParagraphs(Font &font, const std::pmr::vector<size_t> &indices,
+                       std::pmr::memory_resource *scratch);
+  void Measure(LayoutParagraph &paragraph) const;
+  void FindBreaks(LayoutParagraph &paragraph);
+  void Wrap(LayoutParagraph &paragraph) const;
+  LayoutLine CreateLine(const LayoutParagraph &paragraph, const size_t &start,
+                        const size_t &end) const;
+
+  std::vector<LayoutParagraph> paragraphs;
+  LayoutOptions options{};
+  hb_position_t extent{NO_WRAP};
+  uint64_t fontGeneration{0};
+
+  UBreakIterator *breakIterator{nullptr};
+  std::string breakLocale;
+};
+
+#endif
@@ -1,71 +1,38 @@
 #include "text_renderer.hpp"
 
-#include <utf8cpp/utf8.h>
-
 #include "colors.hpp"
 #include "draw_glyph.hpp"
 #include "font.hpp"
 
 namespace {
-void DrawRect(SDL_Renderer *renderer, DebugSettings &debug, const float &x,
-              const float &y, const float &w, const float &h,
-              const SDL_Color &color) {
-
-  if (w == 0 || h == 0)
-    return;
-
-  SDL_FRect rect{x, y, w, h};
-  SDL_Rect bound;
-  SDL_GetRenderViewport(renderer, &bound);
-
-  /*
-   * Adjust the coordinate, and recalculate the new y origin of the rectangle.
-   *
-   * The given rectangle value has its origin in the bottom-left corner while
-   * SDL expects the origin in the top-left corner.
-   */
-  rect.y = static_cast<float>(bound.h) - rect.y - rect.h;
-
-  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-
-  SDL_RenderFillRect(renderer, &rect);
-}
-
-void DrawLine(SDL_Renderer *renderer, DebugSettings &debug, const float &x1,
-              const float &y1, const float &x2, const float &y2,
-              const SDL_Color &color) {
-  SDL_Rect bound;
-  SDL_GetRenderViewport(renderer, &bound);
-
-  SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-
-  float actualY1 = static_cast<float>(bound.h) - y1;
-  float actualY2 = static_cast<float>(bound.h) - y2;
-
-  SDL_RenderLine(renderer, x1, actualY1, x2, actualY2);
-}
-
+// The extent of a line across its direction, from the baseline.
+struct LineExtent {
+  float ascend;
+  float descend;
+  bool isVertical;
+};
+
+// Drawn under the glyphs, in a batch of its own.
 void DrawHorizontalLineDebug(SDL_Renderer *renderer, DebugSettings &debug,
                              const float &lineHeight, const float &ascend,
                              const float &descend) {
   if (!debug.enabled)
     return;
 
-  SDL_Rect bound;
-  SDL_GetRenderViewport(renderer, &bound);
+  DebugOverlay overlay(renderer, debug);
+
+  const float width = overlay.Width();
 
-  float y = bound.h - lineHeight;
+  float y = overlay.Height() - lineHeight;
   do {
     if (debug.debugAscend) {
-      DrawRect(renderer, debug, 0, y, bound.w, ascend, debugAscendColor);
+      overlay.FillRect(0, y, width, ascend, debugAscendColor);
     }
     if (debug.debugDescend) {
-      DrawRect(renderer, debug, 0, y, bound.w, descend, debugDescendColor);
+      overlay.FillRect(0, y, width, descend, debugDescendColor);
     }
     if (debug.debugBaseline) {
-      DrawLine(renderer, debug, 0, y, bound.w, y, debugBaselineColor);
+      overlay.Line(0, y, width, y, debugBaselineColor);
     }
     y -= lineHeight;
   } while (y > 0);
@@ -77,183 +44,207 @@ void DrawVerticalLineDebug(SDL_Renderer *renderer, DebugSettings &debug,
   if (!debug.enabled)
     return;
 
-  SDL_Rect bound;
-  SDL_GetRenderViewport(renderer, &bound);
+  DebugOverlay overlay(renderer, debug);
+
+  const float height = overlay.Height();
 
-  float x = bound.w - lineWidth;
+  float x = overlay.Width() - lineWidth;
   do {
     if (debug.debugAscend) {
-      DrawRect(renderer, debug, x, 0, ascend, bound.h, debugAscendColor);
+      overlay.FillRect(x, 0, ascend, height, debugAscendColor);
     }
     if (debug.debugDescend) {
-      DrawRect(renderer, debug, x, 0, descend, bound.h, debugDescendColor);
+      overlay.FillRect(x, 0, descend, height, debugDescendColor);
     }
     if (debug.debugBaseline) {
-      DrawLine(renderer, debug, x, 0, x, bound.h, debugBaselineColor);
+      overlay.Line(x, 0, x, height, debugBaselineColor);
     }
     x += lineWidth;
   } while (x > 0);
 }
-} // namespace
 
-void TextRenderNoShape(SDL_Renderer *renderer, DebugSettings &debug, Font &font,
-                       const std::string &str, const SDL_Color &color) {
-  if (!font.IsValid())
+/*
+ * Draws the overlays of a glyph that come from shaping, `x` and `y` being the
+ * pen position before the glyph.
+ */
+void DrawShapingDebug(DebugOverlay &overlay, const ShapedGlyph &glyph,
+                      const bool &isClusterStart, const LineExtent &extent,
+                      const float &x, const float &y) {
+  const auto &debug = overlay.Settings();
+  if (!debug.enabled)
     return;
 
-  SDL_Rect bound;
-  SDL_GetRenderViewport(renderer, &bound);
+  const float xAdvance = HBPosToFloat(glyph.xAdvance);
+  const float yAdvance = HBPosToFloat(glyph.yAdvance);
 
-  int x = 0, y = bound.h - font.LineHeight();
-  auto u16str = utf8::utf8to16(str);
+  if (debug.debugClusters && isClusterStart) {
+    if (extent.isVertical) {
+      overlay.Line(x + extent.descend, y, x + extent.ascend, y,
+                   debugClusterColor);
+    } else {
+      overlay.Line(x, y + extent.descend, x, y + extent.ascend,
+                   debugClusterColor);
+    }
+  }
 
-  DrawHorizontalLineDebug(renderer, debug, font.LineHeight(), font.Ascend(),
-                          font.Descend());
+  if (debug.debugAdvanceBox) {
+    if (extent.isVertical) {
+      overlay.Rect(x + extent.descend, y + yAdvance,
+                   extent.ascend - extent.descend, -yAdvance,
+                   debugAdvanceBoxColor);
+    } else {
+      overlay.Rect(x, y + extent.descend, xAdvance,
+                   extent.ascend - extent.descend, debugAdvanceBoxColor);
+    }
+  }
 
-  for (auto &u : u16str) {
-    if (u == '\n') {
-      x = 0;
-      y -= font.LineHeight();
+  if (debug.debugAdvance) {
+    overlay.Line(x, y, x + xAdvance, y + yAdvance, debugAdvanceColor);
+    overlay.Point(x + xAdvance, y + yAdvance, debugAdvanceColor);
+  }
+}
 
-      continue;
+void DrawLayoutLine(SDL_Renderer *renderer, DebugOverlay &overlay,
+                    LinearCompositor &compositor, Font &font,
+                    const LayoutLine &line, const LineExtent &extent,
+                    const SDL_Color &color, float x, float y) {
+  // Flushed at the end of the line, before the overlay.
+  OutlineBatch outlines(renderer);
+  const bool isVectorMode = font.IsVectorMode();
+  const bool isComposited = LinearCompositor::IsEnabled();
+
+  for (const auto &run : line.runs) {
+    for (size_t i = run.glyphStart; i < run.glyphEnd; i++) {
+      const auto &glyph = run.shaped->glyphs[i];
+      const bool isClusterStart =
+          i == run.glyphStart ||
+          run.shaped->glyphs[i - 1].cluster != glyph.cluster;
+
+      if (isVectorMode) {
+        DrawOutline(outlines, overlay, font.GetOutline(glyph.index),
+                    font.OutlineScale(), color, x, y, glyph);
+      } else if (isComposited) {
+        DrawGlyph(compositor, overlay, font.GetBitmap(glyph.index), color, x,
+                  y, glyph);
+      } else {
+        auto &g = font.GetGlyph(renderer, glyph.index);
+        DrawGlyph(renderer, overlay, g, color, x, y, glyph);
+      }
+      DrawShapingDebug(overlay, glyph, isClusterStart, extent, x, y);
+
+      x += HBPosToFloat(glyph.xAdvance);
+      y += HBPosToFloat(glyph.yAdvance);
     }
-
-    auto &g = font.GetGlyphFromChar(renderer, u);
-    DrawGlyph(renderer, debug, font, g, color, x, y);
-    x += g.advance;
   }
 }
 
-void TextRenderLeftToRight(SDL_Renderer *renderer, DebugSettings &debug,
-                           Font &font, const std::string &str,
-                           const SDL_Color &color, const std::string &language,
-                           const hb_script_t &script) {
+/*
+ * The lines are already broken and their runs put in visual order by the
+ * layout. For the right-to-left paragraph direction each line is aligned to
+ * the right edge.
+ */
+void TextRenderHorizontal(SDL_Renderer *renderer, DebugSettings &debug,
+                          Font &font, const TextLayout &layout,
+                          const SDL_Color &color, ClusterIndex &index) {
+  index.Clear(false);
+
   if (!font.IsValid())
     return;
 
   SDL_Rect bound;
   SDL_GetRenderViewport(renderer, &bound);
 
-  auto u16str = utf8::utf8to16(str);
-  auto lineStart = u16str.begin();
-  int y = bound.h - font.LineHeight();
+  float y = bound.h - font.LineHeight();
 
   DrawHorizontalLineDebug(renderer, debug, font.LineHeight(), font.Ascend(),
                           font.Descend());
 
-  while (true) {
-    auto lineEnd = std::find(lineStart, u16str.end(), '\n');
-
-    std::u16string line(lineStart, lineEnd);
+  DebugOverlay overlay(renderer, debug);
 
-    hb_buffer_t *buffer = hb_buffer_create();
-    hb_buffer_set_direction(buffer, HB_DIRECTION_LTR);
+  // Declared after the overlay, so the glyphs are flushed under it.
+  LinearCompositor compositor(renderer);
+  const LineExtent extent{font.Ascend(), font.Descend(), false};
 
-    if (!language.empty())
-      hb_buffer_set_language(
-          buffer, hb_language_from_string(language.c_str(), language.length()));
+  const bool isRightAligned = layout.Options().direction == HB_DIRECTION_RTL;
 
-    hb_buffer_set_script(buffer, script);
+  const auto &paragraphs = layout.Paragraphs();
+  for (size_t p = 0; p < paragraphs.size(); p++) {
+    for (const auto &line : paragraphs[p].lines) {
+      if (y + font.Ascend() < 0)
+        return;
 
-    hb_buffer_add_utf16(buffer,
-                        reinterpret_cast<const uint16_t *>(line.c_str()),
-                        line.size(), 0, line.size());
+      float x = isRightAligned ? bound.w - HBPosToFloat(line.advance) : 0;
+      DrawLayoutLine(renderer, overlay, compositor, font, line, extent, color,
+                     x, y);
+      index.AddLine(p, line, x, y, font.Ascend(), font.Descend());
 
-    hb_shape(font.HbFont(), buffer, NULL, 0);
-
-    unsigned int glyph_count = hb_buffer_get_length(buffer);
-    hb_glyph_info_t *glyph_infos = hb_buffer_get_glyph_infos(buffer, NULL);
-    hb_glyph_position_t *glyph_positions =
-        hb_buffer_get_glyph_positions(buffer, NULL);
-
-    int x = 0;
-
-    for (int i = 0; i < glyph_count; i++) {
-      auto index = glyph_infos[i].codepoint;
-
-      auto &g = font.GetGlyph(renderer, index);
-      DrawGlyph(renderer, debug, font, g, color, x, y, glyph_positions[i]);
-      x += g.advance;
+      y -= font.LineHeight();
     }
-    hb_buffer_destroy(buffer);
-
-    if (lineEnd == u16str.end())
-      break;
-
-    lineStart = lineEnd + 1;
-    y -= font.LineHeight();
   }
 }
+} // namespace
 
-void TextRenderRightToLeft(SDL_Renderer *renderer, DebugSettings &debug,
-                           Font &font, const std::string &str,
-                           const SDL_Color &color, const std::string &language,
-                           const hb_script_t &script) {
+void TextRenderNoShape(SDL_Renderer *renderer, DebugSettings &debug, Font &font,
+                       std::u16string_view text, const SDL_Color &color) {
   if (!font.IsValid())
     return;
 
-  auto u16str = utf8::utf8to16(str);
-  auto lineStart = u16str.begin();
-
-  hb_font_extents_t extents;
-  hb_font_get_extents_for_direction(font.HbFont(), HB_DIRECTION_RTL, &extents);
-
   SDL_Rect bound;
   SDL_GetRenderViewport(renderer, &bound);
 
-  int y = bound.h - font.LineHeight();
+  int x = 0, y = bound.h - font.LineHeight();
 
   DrawHorizontalLineDebug(renderer, debug, font.LineHeight(), font.Ascend(),
                           font.Descend());
 
-  while (true) {
-    auto lineEnd = std::find(lineStart, u16str.end(), '\n');
-
-    std::u16string line(lineStart, lineEnd);
-
-    hb_buffer_t *buffer = hb_buffer_create();
-    hb_buffer_set_direction(buffer, HB_DIRECTION_RTL);
-
-    if (!language.empty())
-      hb_buffer_set_language(
-          buffer, hb_language_from_string(language.c_str(), language.length()));
+  DebugOverlay overlay(renderer, debug);
 
-    hb_buffer_set_script(buffer, script);
+  // Declared after the overlay, so the glyphs are flushed under it.
+  LinearCompositor compositor(renderer);
+  OutlineBatch outlines(renderer);
 
-    hb_buffer_add_utf16(buffer,
-                        reinterpret_cast<const uint16_t *>(line.c_str()),
-                        line.size(), 0, line.size());
-
-    hb_shape(font.HbFont(), buffer, NULL, 0);
-
-    unsigned int glyph_count = hb_buffer_get_length(buffer);
-    hb_glyph_info_t *glyph_infos = hb_buffer_get_glyph_infos(buffer, NULL);
-    hb_glyph_position_t *glyph_positions =
-        hb_buffer_get_glyph_positions(buffer, NULL);
-
-    int x = bound.w;
+  for (auto &u : text) {
+    if (u == '\n') {
+      x = 0;
+      y -= font.LineHeight();
 
-    for (int i = glyph_count - 1; i >= 0; i--) {
-      auto index = glyph_infos[i].codepoint;
+      continue;
+    }
 
-      auto &g = font.GetGlyph(renderer, index);
-      x -= HBPosToFloat(glyph_positions[i].x_advance);
-      DrawGlyph(renderer, debug, font, g, color, x, y, glyph_positions[i]);
+    if (font.IsVectorMode()) {
+      const auto &outline = font.GetOutlineFromChar(u);
+      DrawOutline(outlines, overlay, outline, font.OutlineScale(), color, x,
+                  y);
+      x += static_cast<int>(outline.advance * font.OutlineScale());
+    } else if (LinearCompositor::IsEnabled()) {
+      const auto &bitmap = font.GetBitmapFromChar(u);
+      DrawGlyph(compositor, overlay, bitmap, color, x, y);
+      x += bitmap.advance;
+    } else {
+      auto &g = font.GetGlyphFromChar(renderer, u);
+      DrawGlyph(renderer, overlay, g, color, x, y);
+      x += g.advance;
     }
-    hb_buffer_destroy(buffer);
+  }
+}
 
-    if (lineEnd == u16str.end())
-      break;
+void TextRenderLeftToRight(SDL_Renderer *renderer, DebugSettings &debug,
+                           Font &font, const TextLayout &layout,
+                           const SDL_Color &color, ClusterIndex &index) {
+  TextRenderHorizontal(renderer, debug, font, layout, color, index);
+}
 
-    lineStart = lineEnd + 1;
-    y -= font.LineHeight();
-  }
+void TextRenderRightToLeft(SDL_Renderer *renderer, DebugSettings &debug,
+                           Font &font, const TextLayout &layout,
+                           const SDL_Color &color, ClusterIndex &index) {
+  TextRenderHorizontal(renderer, debug, font, layout, color, index);
 }
 
 void TextRenderTopToBottom(SDL_Renderer *renderer, DebugSettings &debug,
-                           Font &font, const std::string &str,
-                           const SDL_Color &color, const std::string &language,
-                           const hb_script_t &script) {
+                           Font &font, const TextLayout &layout,
+                           const SDL_Color &color, ClusterIndex &index) {
+  index.Clear(true);
+
   if (!font.IsValid())
     return;
 
@@ -269,55 +260,27 @@ void TextRenderTopToBottom(SDL_Renderer *renderer, DebugSettings &debug,
 
   const auto lineWidth = -ascend + descend + linegap;
 
-  auto u16str = utf8::utf8to16(str);
-  auto lineStart = u16str.begin();
-  int x = bound.w + lineWidth;
+  float x = bound.w + lineWidth;
 
-  if (debug.enabled) {
-    DrawVerticalLineDebug(renderer, debug, lineWidth, ascend, descend);
-  }
+  DrawVerticalLineDebug(renderer, debug, lineWidth, ascend, descend);
 
-  while (true) {
-    auto lineEnd = std::find(lineStart, u16str.end(), '\n');
+  DebugOverlay overlay(renderer, debug);
 
-    std::u16string line(lineStart, lineEnd);
+  // Declared after the overlay, so the glyphs are flushed under it.
+  LinearCompositor compositor(renderer);
+  const LineExtent extent{ascend, descend, true};
 
-    hb_buffer_t *buffer = hb_buffer_create();
-    hb_buffer_set_direction(buffer, HB_DIRECTION_TTB);
+  const auto &paragraphs = layout.Paragraphs();
+  for (size_t p = 0; p < paragraphs.size(); p++) {
+    for (const auto &line : paragraphs[p].lines) {
+      if (x < lineWidth)
+        return;
 
-    if (!language.empty())
-      hb_buffer_set_language(
-          buffer, hb_language_from_string(language.c_str(), language.length()));
+      DrawLayoutLine(renderer, overlay, compositor, font, line, extent, color,
+                     x, bound.h);
+      index.AddLine(p, line, x, bound.h, ascend, descend);
 
-    hb_buffer_set_script(buffer, script);
-
-    hb_buffer_add_utf16(buffer,
-                        reinterpret_cast<const uint16_t *>(line.c_str()),
-                        line.size(), 0, line.size());
-
-    hb_shape(font.HbFont(), buffer, NULL, 0);
-
-    unsigned int glyph_count = hb_buffer_get_length(buffer);
-    hb_glyph_info_t *glyph_infos = hb_buffer_get_glyph_infos(buffer, NULL);
-    hb_glyph_position_t *glyph_positions =
-        hb_buffer_get_glyph_positions(buffer, NULL);
-
-    int y = bound.h;
-
-    for (int i = 0; i < glyph_count; i++) {
-      auto index = glyph_infos[i].codepoint;
-
-      auto &g = font.GetGlyph(renderer, index);
-      DrawGlyph(renderer, debug, font, g, color, x, y, glyph_positions[i]);
-
-      y += HBPosToFloat(glyph_positions[i].y_advance);
+      x += lineWidth;
     }
-    hb_buffer_destroy(buffer);
-
-    if (lineEnd == u16str.end())
-      break;
-
-    lineStart = lineEnd + 1;
-    x += lineWidth;
   }
-}
\ No newline at end of file
+}
@@ -1,36 +1,32 @@
 #pragma once
 
+#include "cluster_index.hpp"
 #include "debug_settings.hpp"
 #include "font.hpp"
+#include "text_layout.hpp"
 #include <SDL3/SDL.h>
 #include <functional>
 #include <harfbuzz/hb.h>
+#include <string_view>
 
 enum class TextDirection {
   LeftToRight,
   TopToBottom,
-#ifdef ENABLE_RTL
   RightToLeft,
-#endif
 };
 
 void TextRenderNoShape(SDL_Renderer *renderer, DebugSettings &debug, Font &font,
-                       const std::string &str, const SDL_Color &color);
+                       std::u16string_view text, const SDL_Color &color);
 
+// The shaped renderers also record where the clusters are drawn in `index`.
 void TextRenderLeftToRight(SDL_Renderer *renderer, DebugSettings &debug,
-                           Font &font, const std::string &str,
-                           const SDL_Color &color, const std::string &language,
-                           const hb_script_t &script);
+                           Font &font, const TextLayout &layout,
+                           const SDL_Color &color, ClusterIndex &index);
 
 void TextRenderTopToBottom(SDL_Renderer *renderer, DebugSettings &debug,
-                           Font &font, const std::string &str,
-                           const SDL_Color &color, const std::string &language,
-                           const hb_script_t &script);
+                           Font &font, const TextLayout &layout,
+                           const SDL_Color &color, ClusterIndex &index);
 
-#ifdef ENABLE_RTL
-
-void TextRenderRightToLeft(SDL_Renderer *renderer, Context &debug, Font &font,
-                           const std::string &str, const SDL_Color &color,
-                           const std::string &language,
-                           const hb_script_t &script);
-#endif
+void TextRenderRightToLeft(SDL_Renderer *renderer, DebugSettings &debug,
+                           Font &font, const TextLayout &layout,
+                           const SDL_Color &color, ClusterIndex &index);
@@ -2,8 +2,9 @@
 #include <array>
 constexpr std::array<SDL_Color, 256> glyphPaletteColor();
 
-SDL_Texture *LoadTextureFromBitmap(SDL_Renderer *renderer, FT_Bitmap &bitmap) {
-  if (bitmap.width == 0 || bitmap.rows == 0) {
+SDL_Texture *LoadTextureFromBitmap(SDL_Renderer *renderer,
+                                   const GlyphBitmap &bitmap) {
+  if (bitmap.width == 0 || bitmap.height == 0) {
     return nullptr;
   }
 
@@ -13,8 +14,8 @@ SDL_Texture *LoadTextureFromBitmap(SDL_Renderer *renderer, FT_Bitmap &bitmap) {
   SDL_SetPaletteColors(palette, glyphPalette.data(), 0, glyphPalette.size());
 
   auto *surface = SDL_CreateSurfaceFrom(
-      static_cast<int>(bitmap.width), static_cast<int>(bitmap.rows),
-      SDL_PIXELFORMAT_INDEX8, bitmap.buffer, static_cast<int>(bitmap.pitch));
+      bitmap.width, bitmap.height, SDL_PIXELFORMAT_INDEX8,
+      const_cast<uint8_t *>(bitmap.pixels.data()), bitmap.width);
 
   SDL_SetSurfacePalette(surface, palette);
 
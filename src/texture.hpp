@@ -1,11 +1,10 @@
 #ifndef TEXTURE_HPP
 #define TEXTURE_HPP
 
+#include "font.hpp"
 #include <SDL3/SDL.h>
 
-#include <freetype/freetype.h>
-#include FT_BITMAP_H
-
-SDL_Texture *LoadTextureFromBitmap(SDL_Renderer *renderer, FT_Bitmap &bitmap);
+SDL_Texture *LoadTextureFromBitmap(SDL_Renderer *renderer,
+                                   const GlyphBitmap &bitmap);
 
 #endif
@@ -0,0 +1,109 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(const size_t &threadCount) {
+  threads.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; i++) {
+    threads.emplace_back(
+        [this](std::stop_token stopToken) { Run(stopToken); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  for (auto &t : threads) {
+    t.request_stop();
+  }
+  condition.notify_all();
+}
+
+ThreadPool &ThreadPool::Shared() {
+  static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) -
+                         1);
+
+  return pool;
+}
+
+void ThreadPool::SetJobDoneCallback(std::function<void()> callback) {
+  std::scoped_lock lock(mutex);
+  jobDoneCallback = std::move(callback);
+}
+
+void ThreadPool::ForEach(const size_t &count,
+                         const std::function<void(size_t)> &job) {
+  if (count == 0)
+    return;
+
+  // Helpers may only start after the loop is over, so what they use is kept
+  // alive by them. `job` is only called while the caller is still waiting.
+  struct State {
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    size_t count{0};
+    const std::function<void(size_t)> *job{nullptr};
+
+    std::mutex mutex;
+    std::condition_variable finished;
+  };
+
+  auto state = std::make_shared<State>();
+  state->count = count;
+  state->job = &job;
+
+  auto work = [state]() {
+    size_t completed = 0;
+    for (auto i = state->next++; i < state->count; i = state->next++) {
+      (*state->job)(i);
+      completed++;
+    }
+
+    if (completed > 0 &&
+        state->done.fetch_add(completed) + completed == state->count) {
+      std::scoped_lock lock(state->mutex);
+      state->finished.notify_all();
+    }
+  };
+
+  const size_t helperCount = std::min(ThreadCount(), count - 1);
+  for (size_t i = 0; i < helperCount; i++) {
+    Enqueue(work);
+  }
+
+  work();
+
+  std::unique_lock lock(state->mutex);
+  state->finished.wait(lock,
+                       [&state] { return state->done == state->count; });
+}
+
+void ThreadPool::Enqueue(std::function<void()> job) {
+  {
+    std::scoped_lock lock(mutex);
+    jobs.push_back(std::move(job));
+  }
+  condition.notify_one();
+}
+
+void ThreadPool::Run(std::stop_token stopToken) {
+  while (true) {
+    std::function<void()> job;
+    std::function<void()> jobDone;
+    {
+      std::unique_lock lock(mutex);
+      if (!condition.wait(lock, stopToken, [this] { return !jobs.empty(); })) {
+        return;
+      }
+
+      job = std::move(jobs.front());
+      jobs.pop_front();
+      jobDone = jobDoneCallback;
+    }
+
+    job();
+
+    if (jobDone) {
+      jobDone();
+    }
+  }
+}
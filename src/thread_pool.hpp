@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+  explicit ThreadPool(const size_t &threadCount);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+
+  // The pool shared by the views, sized to leave one core to the UI thread.
+  static ThreadPool &Shared();
+
+  size_t ThreadCount() const { return threads.size(); }
+
+  // Called on the worker thread after each job, e.g. to wake the UI thread up.
+  void SetJobDoneCallback(std::function<void()> callback);
+
+  template <class F>
+  auto Submit(F &&job) -> std::future<std::invoke_result_t<F>> {
+    using Result = std::invoke_result_t<F>;
+
+    auto task =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+    auto future = task->get_future();
+
+    Enqueue([task]() { (*task)(); });
+
+    return future;
+  }
+
+  /*
+   * Calls `job` with every index below `count` and returns when all calls are
+   * done. Idle workers take the next index as soon as they finish one, and
+   * the calling thread takes part too, so this can be used from a job
+   * without waiting on the workers it occupies.
+   */
+  void ForEach(const size_t &count, const std::function<void(size_t)> &job);
+
+private:
+  void Enqueue(std::function<void()> job);
+  void Run(std::stop_token stopToken);
+
+  std::mutex mutex;
+  std::condition_variable_any condition;
+  std::deque<std::function<void()>> jobs;
+  std::function<void()> jobDoneCallback;
+  std::vector<std::jthread> threads;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "ui_font.hpp"
+
+#include "io_util.hpp"
+#include <IconsForkAwesome.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <imgui.h>
+#include <set>
+#include <spdlog/spdlog.h>
+#include <utf8/cpp20.h>
+
+namespace {
+constexpr char UI_GLYPHS_FILE[] = "ui_glyphs.txt";
+constexpr float UI_FONT_SIZE = 20.0f;
+
+constexpr char BASE_FONT[] = "fonts/NotoSans-Regular.ttf";
+constexpr char ICON_FONT[] = "fonts/forkawesome-webfont.ttf";
+
+constexpr ImWchar ICON_RANGES[] = {ICON_MIN_FK, ICON_MAX_FK, 0};
+
+// Blocks each script font is merged in for, in the same form as the ImGui
+// glyph ranges.
+constexpr ImWchar THAI_BLOCKS[] = {0x0E00, 0x0E7F, 0};
+constexpr ImWchar KANA_HAN_BLOCKS[] = {
+    0x2E80, 0x30FF, // CJK radicals, punctuation, Hiragana and Katakana
+    0x31F0, 0x31FF, // Katakana phonetic extensions
+    0x3400, 0x4DBF, // CJK unified ideographs extension A
+    0x4E00, 0x9FFF, // CJK unified ideographs
+    0xF900, 0xFAFF, // CJK compatibility ideographs
+    0xFF00, 0xFFEF, // Half-width and full-width forms
+    0,
+};
+constexpr ImWchar HANGUL_BLOCKS[] = {
+    0x1100, 0x11FF, // Hangul Jamo
+    0x3130, 0x318F, // Hangul compatibility Jamo
+    0xAC00, 0xD7AF, // Hangul syllables
+    0,
+};
+
+struct ScriptFont {
+  const char *path;
+  const ImWchar *blocks;
+};
+
+// When several fonts have a character, the first one wins.
+constexpr ScriptFont SCRIPT_FONTS[] = {
+    {"fonts/NotoSansJP-Regular.ttf", KANA_HAN_BLOCKS},
+    {"fonts/NotoSansThai-Regular.ttf", THAI_BLOCKS},
+    {"fonts/NotoSansKR-Regular.ttf", HANGUL_BLOCKS},
+    {"fonts/NotoSansSC-Regular.ttf", KANA_HAN_BLOCKS},
+    {"fonts/NotoSansTC-Regular.ttf", KANA_HAN_BLOCKS},
+};
+
+std::set<ImWchar> requested;
+bool isDirty = false;
+bool isSaveNeeded = false;
+bool isWarm = false;
+
+// Must outlive the atlas build.
+ImVector<ImWchar> ranges;
+
+std::filesystem::path GlyphsFilePath() {
+  return GetPreferencePath() / UI_GLYPHS_FILE;
+}
+
+bool IsInBlocks(const ImWchar &codepoint, const ImWchar *blocks) {
+  for (; blocks[0] != 0; blocks += 2) {
+    if (codepoint >= blocks[0] && codepoint <= blocks[1])
+      return true;
+  }
+
+  return false;
+}
+
+bool IsNeeded(const ScriptFont &font) {
+  return std::ranges::any_of(requested, [&font](const ImWchar &codepoint) {
+    return IsInBlocks(codepoint, font.blocks);
+  });
+}
+
+bool Insert(const std::string_view &text) {
+  bool isInserted = false;
+
+  try {
+    for (auto iter = text.begin(); iter != text.end();) {
+      const auto codepoint = utf8::next(iter, text.end());
+
+      // Latin-1 is always in the atlas, and ImGui stops at the BMP.
+      if (codepoint <= 0xFF || codepoint > 0xFFFF)
+        continue;
+      if (codepoint >= ICON_MIN_FK && codepoint <= ICON_MAX_FK)
+        continue;
+
+      isInserted |= requested.insert(static_cast<ImWchar>(codepoint)).second;
+    }
+  } catch (const utf8::exception &e) {
+    spdlog::warn("Invalid UTF-8 in UI text: {}", e.what());
+  }
+
+  return isInserted;
+}
+
+void BuildAtlas() {
+  const auto start = std::chrono::steady_clock::now();
+
+  ImFontGlyphRangesBuilder builder;
+  builder.AddRanges(ImGui::GetIO().Fonts->GetGlyphRangesDefault());
+  for (const auto &codepoint : requested) {
+    builder.AddChar(codepoint);
+  }
+
+  ranges.clear();
+  builder.BuildRanges(&ranges);
+
+  auto &fonts = *ImGui::GetIO().Fonts;
+  fonts.Clear();
+  fonts.AddFontFromFileTTF(BASE_FONT, UI_FONT_SIZE, nullptr, ranges.Data);
+
+  ImFontConfig config;
+  config.MergeMode = true;
+
+  fonts.AddFontFromFileTTF(ICON_FONT, UI_FONT_SIZE, &config, ICON_RANGES);
+
+  int scriptFontCount = 0;
+  for (const auto &font : SCRIPT_FONTS) {
+    if (!IsNeeded(font))
+      continue;
+
+    fonts.AddFontFromFileTTF(font.path, UI_FONT_SIZE, &config, ranges.Data);
+    scriptFontCount++;
+  }
+
+  fonts.Build();
+
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  spdlog::info("UI font atlas built in {:.1f} ms ({} extra characters, {} "
+               "script fonts).",
+               elapsed.count(), requested.size(), scriptFontCount);
+}
+} // namespace
+
+void UiFontInit() {
+  const auto path = GlyphsFilePath();
+
+  if (std::filesystem::exists(path)) {
+    Insert(LoadFile<std::string>(path, std::ios::in | std::ios::binary));
+    isWarm = true;
+  }
+
+  BuildAtlas();
+  isDirty = false;
+}
+
+void UiFontRequest(const std::string_view &text) {
+  if (Insert(text)) {
+    isDirty = true;
+    isSaveNeeded = true;
+  }
+}
+
+bool UiFontUpdate() {
+  if (!isDirty)
+    return false;
+
+  BuildAtlas();
+  isDirty = false;
+
+  return true;
+}
+
+bool UiFontIsWarm() { return isWarm; }
+
+void UiFontCleanUp() {
+  if (!isSaveNeeded)
+    return;
+
+  std::string str;
+  for (const auto &codepoint : requested) {
+    utf8::append(static_cast<uint32_t>(codepoint), std::back_inserter(str));
+  }
+
+  std::fstream output(GlyphsFilePath(), std::ios::out | std::ios::binary);
+  output.write(str.c_str(), str.length());
+  output.close();
+
+  isSaveNeeded = false;
+}
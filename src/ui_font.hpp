@@ -0,0 +1,29 @@
+#ifndef UI_FONT_HPP
+#define UI_FONT_HPP
+
+#include <string_view>
+
+/*
+ * The ImGui font atlas only holds Latin and the icons at first. The scripts
+ * fonts are merged in once the UI shows one of their characters, and only
+ * the characters actually shown are baked. The characters needed are kept
+ * for the next start, so the first frame already has them.
+ */
+
+// Builds the initial atlas.
+void UiFontInit();
+
+// Marks the characters of the UTF-8 `text` as needed. They are added to the
+// atlas on the next UiFontUpdate.
+void UiFontRequest(const std::string_view &text);
+
+// Rebuilds the atlas if new characters were requested. Must be called outside
+// of a frame, returns true when the font texture has to be created again.
+bool UiFontUpdate();
+
+// Whether the characters needed by a previous session were found.
+bool UiFontIsWarm();
+
+void UiFontCleanUp();
+
+#endif
@@ -0,0 +1,236 @@
+#include "waterfall_view.hpp"
+
+#include "glyph_atlas.hpp"
+#include "layout_job.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+#include <imgui.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::array SIZE_LADDER{6,  7,  8,  9,  10, 11, 12, 14, 16, 18, 20,
+                                 24, 28, 32, 36, 42, 48, 56, 64, 72, 96, 128};
+
+constexpr int ROW_PADDING = 8;
+constexpr int LABEL_WIDTH = 56;
+constexpr float SCROLL_STEP = 48.0f;
+
+// The atlas is dropped and refilled once it grows past this many pages.
+constexpr size_t MAX_ATLAS_PAGES = 16;
+
+struct Row {
+  int size{0};
+
+  std::shared_ptr<LayoutWorker> worker{std::make_shared<LayoutWorker>()};
+  std::future<LayoutJobOutput> job;
+  LayoutJobInput submitted;
+  bool isSubmitted{false};
+  bool isAtlasStale{false};
+
+  LayoutJobOutput result;
+};
+
+std::vector<Row> rows;
+
+// The font data the rows were created for.
+std::shared_ptr<const std::vector<char>> fontData;
+uint64_t fontHash = 0;
+
+// Jobs of replaced rows, which still own a font until they finish.
+std::vector<std::future<LayoutJobOutput>> retiredJobs;
+
+/*
+ * The glyphs of every size live in the same atlas, keyed by the size. They
+ * stay there when a row is scrolled out of view or the text changes, so only
+ * glyphs that were never seen at a size are rasterized.
+ */
+GlyphAtlas atlas;
+
+float scroll = 0;
+float contentHeight = 0;
+float viewHeight = 0;
+
+bool IsJobRunning(const Row &row) { return row.job.valid(); }
+
+void ResetRows(const Font &font) {
+  std::erase_if(retiredJobs, [](const auto &job) {
+    return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  });
+
+  for (auto &row : rows) {
+    if (IsJobRunning(row)) {
+      retiredJobs.push_back(std::move(row.job));
+    }
+  }
+
+  rows.clear();
+  for (const auto &size : SIZE_LADDER) {
+    rows.push_back({.size = size});
+  }
+
+  fontData = font.Data();
+  fontHash = font.ContentHash();
+}
+
+void CollectResult(SDL_Renderer *renderer, Row &row) {
+  if (!IsJobRunning(row) ||
+      row.job.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+
+  row.result = row.job.get();
+  UploadJobBitmaps(renderer, atlas, row.size, row.result);
+}
+
+// Rows are submitted in ladder order, so the pool picks the small sizes,
+// which are the cheapest to rasterize, first.
+void Submit(Row &row, const LayoutJobInput &input) {
+  if (IsJobRunning(row))
+    return;
+
+  if (row.isSubmitted && !row.isAtlasStale && row.submitted == input)
+    return;
+
+  row.job = ThreadPool::Shared().Submit(
+      [worker = row.worker, data = fontData, hash = fontHash, input,
+       isAtlasStale = row.isAtlasStale]() {
+        if (!worker->font) {
+          worker->font = std::make_unique<Font>();
+          worker->font->Load(data, hash);
+        }
+
+        return RunLayoutJob(*worker, input, isAtlasStale);
+      });
+
+  row.submitted = input;
+  row.isSubmitted = true;
+  row.isAtlasStale = false;
+}
+} // namespace
+
+void WaterfallTick(
+    SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
+    const magic_enum::containers::array<VariationAxis, float> &axisValues,
+    std::u16string_view text, const LayoutOptions &options,
+    const SDL_Color &color) {
+  if (!font.IsValid())
+    return;
+
+  if (font.Data() != fontData) {
+    ResetRows(font);
+  }
+
+  if (atlas.PageCount() > MAX_ATLAS_PAGES) {
+    atlas.Clear();
+    for (auto &row : rows) {
+      row.isAtlasStale = true;
+    }
+  }
+
+  SDL_Rect bound;
+  SDL_GetRenderViewport(renderer, &bound);
+  viewHeight = static_cast<float>(bound.h);
+
+  // Rows only lay out horizontally.
+  LayoutOptions rowOptions = options;
+  if (rowOptions.direction == HB_DIRECTION_TTB) {
+    rowOptions.direction = HB_DIRECTION_LTR;
+  }
+
+  const auto line = text.substr(0, text.find(u'\n'));
+  const bool isRightAligned = rowOptions.direction == HB_DIRECTION_RTL;
+
+  DebugOverlay overlay(renderer, debug);
+
+  float top = -scroll;
+  for (auto &row : rows) {
+    CollectResult(renderer, row);
+
+    Submit(row, {
+                    .fontSize = row.size,
+                    .isAxisValuesSet = true,
+                    .axisValues = axisValues,
+                    .text = std::u16string(line),
+                    .options = rowOptions,
+                });
+
+    const auto &result = row.result;
+
+    // Until the first job of the row finishes, reserve about a line.
+    const float height = result.isValid ? result.lineHeight : row.size * 1.2f;
+
+    if (top + height > 0 && top < bound.h) {
+      const std::string label = std::to_string(row.size) + "px";
+      SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+      SDL_RenderDebugText(
+          renderer, 0, top + (height - SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE) / 2,
+          label.c_str());
+
+      if (result.isValid && !result.paragraphs.empty() &&
+          !result.paragraphs.front().lines.empty()) {
+        const auto &layoutLine = result.paragraphs.front().lines.front();
+        const float x = isRightAligned
+                            ? bound.w - HBPosToFloat(layoutLine.advance)
+                            : LABEL_WIDTH;
+        const float baseline = bound.h - (top + result.ascend);
+
+        DrawAtlasLine(renderer, overlay, atlas, row.size, result.generation,
+                      layoutLine, color, x, baseline);
+      }
+    }
+
+    top += height + ROW_PADDING;
+  }
+
+  contentHeight = top + scroll;
+}
+
+void WaterfallDoUI() {
+  auto &io = ImGui::GetIO();
+  if (!io.WantCaptureMouse) {
+    scroll -= io.MouseWheel * SCROLL_STEP;
+  }
+  scroll = std::clamp(scroll, 0.0f, std::max(0.0f, contentHeight - viewHeight));
+
+  if (ImGui::Begin("Waterfall")) {
+    ImGui::SliderFloat("Scroll##waterfall", &scroll, 0.0f,
+                       std::max(0.0f, contentHeight - viewHeight), "%.0f");
+
+    size_t pending = 0;
+    std::chrono::duration<double> totalElapsed{};
+    for (const auto &row : rows) {
+      pending += IsJobRunning(row) ? 1 : 0;
+      totalElapsed += row.result.elapsed;
+    }
+
+    ImGui::LabelText("Sizes", "%zu (%d - %dpx)", SIZE_LADDER.size(),
+                     SIZE_LADDER.front(), SIZE_LADDER.back());
+    ImGui::LabelText("Pending jobs", "%zu", pending);
+    ImGui::LabelText("Job time (total)", "%.1f ms",
+                     totalElapsed.count() * 1000.0);
+    ImGui::LabelText("Atlas", "%zu glyphs, %zu pages", atlas.GlyphCount(),
+                     atlas.PageCount());
+  }
+  ImGui::End();
+}
+
+void WaterfallCleanUp() {
+  for (auto &row : rows) {
+    if (IsJobRunning(row)) {
+      row.job.wait();
+    }
+  }
+  for (auto &job : retiredJobs) {
+    job.wait();
+  }
+
+  retiredJobs.clear();
+  rows.clear();
+  fontData.reset();
+  atlas.Clear();
+}
@@ -0,0 +1,27 @@
+#ifndef WATERFALL_VIEW_HPP
+#define WATERFALL_VIEW_HPP
+
+#include "debug_settings.hpp"
+#include "font.hpp"
+#include "text_layout.hpp"
+#include <SDL3/SDL.h>
+#include <magic_enum/magic_enum_containers.hpp>
+#include <string>
+#include <string_view>
+
+/*
+ * Renders one line of text at a fixed ladder of sizes. Every size has its own
+ * worker font sharing the data of `font`; the sizes are scheduled smallest
+ * first and appear as their jobs finish.
+ */
+void WaterfallTick(
+    SDL_Renderer *renderer, DebugSettings &debug, const Font &font,
+    const magic_enum::containers::array<VariationAxis, float> &axisValues,
+    std::u16string_view text, const LayoutOptions &options,
+    const SDL_Color &color);
+
+void WaterfallDoUI();
+
+void WaterfallCleanUp();
+
+#endif